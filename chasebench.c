@@ -0,0 +1,185 @@
+/*
+ * chasebench.c - Pointer chasing benchmark for the huge page heap
+ *
+ * Frees a large warm up area into one free block in the middle of the
+ * heap, then allocates small nodes (32 to 64 bytes, like those of a list
+ * or tree) interleaved with larger buffers (512 to 1536 bytes), and frees
+ * the buffers. The nodes are linked in a random order and the list is
+ * followed from node to node, which misses the TLB at almost every step
+ * when the nodes are spread over many small pages. It is run with the
+ * segregated list allocator and with its huge page build (seglist-huge),
+ * which takes the buffers from the top of the free block, so the nodes
+ * end up next to each other on a few transparent huge pages.
+ *
+ * For each it prints the time per node followed, the heap size and how
+ * much of the heap the kernel backs by huge pages (AnonHugePages).
+ *
+ * usage: chasebench [-n nodes] [-r repeats]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "mm.h"
+#include "memlib.h"
+
+extern const struct mm_ops seg_mm_ops, huge_mm_ops;
+
+static const struct mm_ops *allocators[] = {
+	&seg_mm_ops,
+	&huge_mm_ops,
+};
+
+#define NUM_ALLOCATORS (sizeof(allocators) / sizeof(allocators[0]))
+
+#define WARM_BLOCKS 32768 /*4 KB blocks of the warm up area, 128 MB*/
+#define WARM_SIZE   4096
+
+/*a node of the list that is followed*/
+typedef struct node {
+	struct node *next;
+	long payload;
+} node;
+
+static unsigned long long rnd(unsigned long long *state){
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static double now(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * huge_kb - Sum the AnonHugePages of the mappings of this process that
+ * overlap the heap, in KB, or -1 if /proc/self/smaps cannot be read
+ */
+static long huge_kb(void){
+	unsigned long lo = (unsigned long) mem_heap_lo(), hi = (unsigned long) mem_heap_hi();
+	unsigned long start, end;
+	int in_heap = 0;
+	char line[256];
+	long kb, sum = 0;
+	FILE *fp;
+
+	if ((fp = fopen("/proc/self/smaps", "r")) == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), fp) != NULL){
+		if (sscanf(line, "%lx-%lx ", &start, &end) == 2)
+			in_heap = start <= hi && end > lo;
+		else if (in_heap && sscanf(line, "AnonHugePages: %ld kB", &kb) == 1)
+			sum += kb;
+	}
+	fclose(fp);
+	return sum;
+}
+
+/*
+ * run - Build the list of n nodes with one allocator and follow it
+ * reps times. Returns the nanoseconds per node followed, or -1, and
+ * the heap size and its huge page backing in KB.
+ */
+static double run(const struct mm_ops *mm, node **nodes, void **warm, size_t n,
+		int reps, size_t *heap_kb, long *hugepage_kb){
+	unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+	void **bufs = (void **) nodes + n; /*the second half of the array*/
+	void *pin;
+	node *p, *t;
+	double start, secs;
+	size_t i, j;
+	long sum = 0;
+	int r;
+
+	mem_reset_brk();
+	if (mm->init() < 0)
+		return -1;
+	for (i = 0; i < WARM_BLOCKS; i++){
+		if ((warm[i] = mm->malloc(WARM_SIZE)) == NULL)
+			return -1;
+	}
+	if ((pin = mm->malloc(64)) == NULL) /*keeps the warm up area off the top of the heap*/
+		return -1;
+	for (i = 0; i < WARM_BLOCKS; i++)
+		mm->free(warm[i]);
+
+	for (i = 0; i < n; i++){
+		if ((nodes[i] = mm->malloc(32 + rnd(&seed) % 33)) == NULL
+		    || (bufs[i] = mm->malloc(512 + rnd(&seed) % 1025)) == NULL)
+			return -1;
+		nodes[i]->payload = i;
+	}
+	for (i = 0; i < n; i++)
+		mm->free(bufs[i]);
+
+	for (i = n; i > 1; i--){ /*link the nodes in a random order*/
+		j = rnd(&seed) % i;
+		t = nodes[i - 1];
+		nodes[i - 1] = nodes[j];
+		nodes[j] = t;
+	}
+	for (i = 0; i < n; i++)
+		nodes[i]->next = nodes[(i + 1) % n];
+
+	start = now();
+	for (r = 0; r < reps; r++){
+		for (i = 0, p = nodes[0]; i < n; i++, p = p->next)
+			sum += p->payload;
+	}
+	secs = now() - start;
+	if (sum != (long) reps * (long) (n * (n - 1) / 2) || mm->checkheap(0))
+		return -1;
+	*heap_kb = mem_heapsize() / 1024;
+	*hugepage_kb = huge_kb();
+	for (i = 0; i < n; i++)
+		mm->free(nodes[i]);
+	mm->free(pin);
+	return secs * 1e9 / ((double) reps * n);
+}
+
+int main(int argc, char **argv){
+	size_t n = 100000, heap_kb, j;
+	int repeats = 20, c;
+	long hugepage_kb;
+	node **nodes;
+	void **warm;
+
+	while ((c = getopt(argc, argv, "n:r:h")) != -1){
+		switch (c){
+		case 'n':
+			n = atol(optarg);
+			break;
+		case 'r':
+			repeats = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: chasebench [-n nodes] [-r repeats]\n");
+			return 1;
+		}
+	}
+	if (n == 0 || (nodes = malloc(2 * n * sizeof(void *))) == NULL
+	    || (warm = malloc(WARM_BLOCKS * sizeof(void *))) == NULL){
+		fprintf(stderr, "chasebench: out of memory\n");
+		return 1;
+	}
+
+	mem_init();
+	printf("%-16s %12s %12s %14s\n", "allocator", "ns/node", "heap KB", "huge page KB");
+	for (j = 0; j < NUM_ALLOCATORS; j++){
+		double ns = run(allocators[j], nodes, warm, n, repeats, &heap_kb, &hugepage_kb);
+
+		if (ns < 0){
+			printf("%-16s %12s\n", allocators[j]->name, "FAILED");
+			return 1;
+		}
+		printf("%-16s %12.2f %12lu %14ld\n", allocators[j]->name, ns,
+			(unsigned long) heap_kb, hugepage_kb);
+	}
+	mem_deinit();
+	return 0;
+}
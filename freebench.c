@@ -0,0 +1,239 @@
+/*
+ * freebench.c - Benchmark for building and tearing down large structures
+ *
+ * Builds a large structure out of small blocks (16 to 128 bytes, like
+ * the nodes of a tree or list) and times freeing all of it: one free
+ * per block, one free_sized per block, and a single free_many on the
+ * array of pointers. The blocks are freed once in the order they were
+ * allocated, which leaves runs of neighbours in the heap, and once in
+ * a random order. Allocators without free_sized or free_many are only
+ * timed with free.
+ *
+ * Then it times building the structure out of blocks of one size, with
+ * one malloc per block and with a single malloc_batch.
+ *
+ * usage: freebench [-n blocks] [-r repeats]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "mm.h"
+#include "memlib.h"
+
+extern const struct mm_ops seg_mm_ops, tlsf_mm_ops, seg_mt_mm_ops, slab_mm_ops;
+extern const struct mm_ops compact_mm_ops, quick_mm_ops;
+
+static int libc_init(void){
+	return 0;
+}
+
+static int libc_checkheap(int verbose){
+	return 0;
+}
+
+/*the C library allocator, as a baseline*/
+static const struct mm_ops libc_mm_ops = {
+	"libc", libc_init, malloc, free, realloc, calloc, aligned_alloc, libc_checkheap
+};
+
+static const struct mm_ops *allocators[] = {
+	&seg_mm_ops,
+	&tlsf_mm_ops,
+	&seg_mt_mm_ops,
+	&slab_mm_ops,
+	&compact_mm_ops,
+	&quick_mm_ops,
+	&libc_mm_ops,
+};
+
+#define NUM_ALLOCATORS (sizeof(allocators) / sizeof(allocators[0]))
+
+#define NODE_SIZE 48 /*bytes of each block of the structure built in one size*/
+
+/*ways of freeing the blocks*/
+enum { BY_FREE, BY_FREE_SIZED, BY_FREE_MANY, NUM_WAYS };
+
+static unsigned long long rnd(unsigned long long *state){
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static double now(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * run - Allocate n blocks, then free them all one way, in allocation
+ * order or shuffled. Returns the seconds the freeing took, or -1.
+ */
+static double run(const struct mm_ops *mm, int way, int shuffle,
+		void **ptrs, size_t *sizes, size_t n){
+	unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+	double start, secs;
+	size_t i, j, s;
+	void *p;
+
+	mem_reset_brk();
+	if (mm->init() < 0)
+		return -1;
+	for (i = 0; i < n; i++){
+		sizes[i] = 16 + rnd(&seed) % 113;
+		if ((ptrs[i] = mm->malloc(sizes[i])) == NULL)
+			return -1;
+		*(char *) ptrs[i] = 1;
+	}
+	if (shuffle){
+		for (i = n; i > 1; i--){
+			j = rnd(&seed) % i;
+			p = ptrs[i - 1];
+			ptrs[i - 1] = ptrs[j];
+			ptrs[j] = p;
+			s = sizes[i - 1];
+			sizes[i - 1] = sizes[j];
+			sizes[j] = s;
+		}
+	}
+
+	start = now();
+	switch (way){
+	case BY_FREE:
+		for (i = 0; i < n; i++)
+			mm->free(ptrs[i]);
+		break;
+	case BY_FREE_SIZED:
+		for (i = 0; i < n; i++)
+			mm->free_sized(ptrs[i], sizes[i]);
+		break;
+	case BY_FREE_MANY:
+		mm->free_many(ptrs, n);
+		break;
+	}
+	secs = now() - start;
+	if (mm->checkheap(0))
+		return -1;
+	return secs;
+}
+
+/*
+ * run_build - Allocate n blocks of NODE_SIZE bytes, with malloc or in
+ * one batch, and touch each. Returns the seconds it took, or -1.
+ */
+static double run_build(const struct mm_ops *mm, int batch, void **ptrs, size_t n){
+	double start, secs;
+	size_t i;
+
+	mem_reset_brk();
+	if (mm->init() < 0)
+		return -1;
+	start = now();
+	if (batch){
+		if (mm->malloc_batch(NODE_SIZE, n, ptrs) != n)
+			return -1;
+	}
+	else{
+		for (i = 0; i < n; i++){
+			if ((ptrs[i] = mm->malloc(NODE_SIZE)) == NULL)
+				return -1;
+		}
+	}
+	for (i = 0; i < n; i++)
+		*(char *) ptrs[i] = 1;
+	secs = now() - start;
+	if (mm->checkheap(0))
+		return -1;
+	return secs;
+}
+
+int main(int argc, char **argv){
+	static const char *order[] = { "alloc", "random" };
+	size_t n = 1000000, j;
+	int repeats = 3, shuffle, way, r, c;
+	void **ptrs;
+	size_t *sizes;
+
+	while ((c = getopt(argc, argv, "n:r:h")) != -1){
+		switch (c){
+		case 'n':
+			n = atol(optarg);
+			break;
+		case 'r':
+			repeats = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: freebench [-n blocks] [-r repeats]\n");
+			return 1;
+		}
+	}
+	if ((ptrs = malloc(n * sizeof(void *))) == NULL
+	    || (sizes = malloc(n * sizeof(size_t))) == NULL){
+		fprintf(stderr, "freebench: out of memory\n");
+		return 1;
+	}
+
+	mem_init();
+	printf("%-16s %-7s %12s %12s %12s\n", "allocator", "order",
+		"free ns", "sized ns", "many ns");
+	for (j = 0; j < NUM_ALLOCATORS; j++){
+		const struct mm_ops *mm = allocators[j];
+
+		for (shuffle = 0; shuffle <= 1; shuffle++){
+			printf("%-16s %-7s", mm->name, order[shuffle]);
+			for (way = 0; way < NUM_WAYS; way++){
+				double best = -1, secs;
+
+				if ((way == BY_FREE_SIZED && mm->free_sized == NULL)
+				    || (way == BY_FREE_MANY && mm->free_many == NULL)){
+					printf(" %12s", "-");
+					continue;
+				}
+				for (r = 0; r < repeats; r++){ /*the best of the repeats*/
+					if ((secs = run(mm, way, shuffle, ptrs, sizes, n)) < 0){
+						printf(" %12s\n", "FAILED");
+						return 1;
+					}
+					if (best < 0 || secs < best)
+						best = secs;
+				}
+				printf(" %12.1f", best / n * 1e9);
+			}
+			printf("\n");
+		}
+	}
+
+	printf("\n%-16s %12s %12s\n", "allocator", "malloc ns", "batch ns");
+	for (j = 0; j < NUM_ALLOCATORS; j++){
+		const struct mm_ops *mm = allocators[j];
+		int batch;
+
+		printf("%-16s", mm->name);
+		for (batch = 0; batch <= 1; batch++){
+			double best = -1, secs;
+
+			if (batch && mm->malloc_batch == NULL){
+				printf(" %12s", "-");
+				continue;
+			}
+			for (r = 0; r < repeats; r++){
+				if ((secs = run_build(mm, batch, ptrs, n)) < 0){
+					printf(" %12s\n", "FAILED");
+					return 1;
+				}
+				if (best < 0 || secs < best)
+					best = secs;
+			}
+			printf(" %12.1f", best / n * 1e9);
+		}
+		printf("\n");
+	}
+	mem_deinit();
+	free(sizes);
+	free(ptrs);
+	return 0;
+}
@@ -0,0 +1,366 @@
+/*
+ * heapmap.c - Draws the heap snapshots mdriver -m writes
+ *
+ * For each trace replayed on each allocator in the file, prints three
+ * tables with a row per snapshot, oldest first:
+ *   1. a map of the heap, a column per width'th of the largest heap of
+ *      the run, from '#' for all allocated to '.' for all free, with
+ *      the heap size, the share of it allocated and how fragmented its
+ *      free bytes are (1 - largest free block / free bytes);
+ *   2. the fragmentation of each of regions equal parts of the heap
+ *      the same way, in tenths, a free block counting for the region
+ *      it starts in;
+ *   3. the free blocks per power of two size class, for the classes
+ *      that ever hold one: the lengths of the free lists of a
+ *      segregated fit allocator with power of two classes.
+ * With -p the maps are also drawn to a PPM image, a band of rows per
+ * snapshot, white for free and blue for allocated bytes.
+ *
+ * usage: heapmap [-w width] [-r regions] [-a allocator] [-t trace] [-p image] file
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "heapmap.h"
+
+#define WIDTH      64   /*columns of the heap map*/
+#define REGIONS    16   /*regions fragmentation is told for*/
+#define IMG_WIDTH  1024 /*pixels across the image*/
+#define IMG_ROWS   4    /*pixel rows per snapshot in the image*/
+
+/*the snapshots of one trace on one allocator*/
+typedef struct {
+	struct heapmap_snap *snaps;
+	uint64_t **runs;
+	size_t num, max;
+} series;
+
+static void *xmalloc(size_t bytes){
+	void *p = malloc(bytes);
+
+	if (p == NULL){
+		fprintf(stderr, "heapmap: out of memory\n");
+		exit(1);
+	}
+	return p;
+}
+
+/*
+ * read_snap - Read the next snapshot of fp into hs and its runs into
+ * *runs. Returns 1, 0 at the end of the file or -1 if it is not one.
+ */
+static int read_snap(FILE *fp, struct heapmap_snap *hs, uint64_t **runs){
+	size_t n = fread(hs, 1, sizeof(*hs), fp);
+
+	if (n == 0)
+		return 0;
+	if (n != sizeof(*hs) || hs->magic != HEAPMAP_MAGIC || hs->version != HEAPMAP_VERSION)
+		return -1;
+	hs->allocator[HEAPMAP_NAME - 1] = hs->trace[HEAPMAP_NAME - 1] = '\0';
+	*runs = xmalloc(hs->num_runs * sizeof(uint64_t) + 1);
+	if (fread(*runs, sizeof(uint64_t), hs->num_runs, fp) != hs->num_runs)
+		return -1;
+	return 1;
+}
+
+/*
+ * cover - Bytes of [start, end) inside [lo, hi)
+ */
+static double cover(double start, double end, double lo, double hi){
+	if (start < lo)
+		start = lo;
+	if (end > hi)
+		end = hi;
+	return end > start ? end - start : 0;
+}
+
+/*
+ * map_row - Split the heap of hs into cells of cell bytes and add the
+ * allocated bytes of each to alloc and all its bytes to bytes. The list
+ * heads and prologue before the first block and the epilogue after the
+ * last count as allocated.
+ */
+static void map_row(const struct heapmap_snap *hs, const uint64_t *runs,
+		double *alloc, double *bytes, int cells, double cell){
+	double off = hs->first, end;
+	uint64_t i;
+	int c;
+
+	for (c = 0; c < cells && c * cell < hs->heap_size; c++){
+		bytes[c] += cover(c * cell, (c + 1) * cell, 0, hs->heap_size);
+		alloc[c] += cover(c * cell, (c + 1) * cell, 0, hs->first);
+	}
+	for (i = 0; i < hs->num_runs; i++){
+		end = off + HEAPMAP_RUN_BYTES(runs[i]);
+		if (HEAPMAP_RUN_ALLOC(runs[i])){
+			for (c = off / cell; c < cells && c * cell < end; c++)
+				alloc[c] += cover(off, end, c * cell, (c + 1) * cell);
+		}
+		off = end;
+	}
+	for (c = off / cell; c < cells && c * cell < hs->heap_size; c++)
+		alloc[c] += cover(off, hs->heap_size, c * cell, (c + 1) * cell);
+}
+
+/*
+ * frag_row - The fragmentation of each region of region bytes of the
+ * heap of hs, or -1 for a region without free bytes
+ */
+static void frag_row(const struct heapmap_snap *hs, const uint64_t *runs,
+		double *frag, int regions, double region){
+	double off = hs->first, free_bytes[REGIONS * 16], largest[REGIONS * 16];
+	uint64_t i, size;
+	int r;
+
+	for (r = 0; r < regions; r++)
+		free_bytes[r] = largest[r] = 0;
+	for (i = 0; i < hs->num_runs; i++){
+		size = HEAPMAP_RUN_BYTES(runs[i]);
+		if (!HEAPMAP_RUN_ALLOC(runs[i]) && (r = off / region) < regions){
+			free_bytes[r] += size;
+			if (size > largest[r])
+				largest[r] = size;
+		}
+		off += size;
+	}
+	for (r = 0; r < regions; r++)
+		frag[r] = free_bytes[r] > 0 ? 1 - largest[r] / free_bytes[r] : -1;
+}
+
+/*
+ * print_series - The three tables of one trace on one allocator
+ */
+static void print_series(const series *s, int width, int regions){
+	static const char ramp[] = ".:-=+*%#"; /*all free to all allocated*/
+	double alloc[WIDTH * 16], bytes[WIDTH * 16], frag[REGIONS * 16];
+	double max_heap = 0, cell, region;
+	size_t i;
+	int c, any[MM_SIZE_CLASSES] = {0};
+
+	for (i = 0; i < s->num; i++){
+		if (s->snaps[i].heap_size > max_heap)
+			max_heap = s->snaps[i].heap_size;
+		for (c = 0; c < MM_SIZE_CLASSES; c++)
+			any[c] |= s->snaps[i].class_blocks[c] != 0;
+	}
+	cell = max_heap / width;
+	region = max_heap / regions;
+
+	printf("\n%s on %s: %u ops, %lu snapshots, heap up to %.0f bytes\n",
+		s->snaps[0].allocator, s->snaps[0].trace, s->snaps[0].num_ops,
+		(unsigned long) s->num, max_heap);
+	printf("\nHeap map, a column is %.0f bytes ('#' allocated, '.' free, blank past the heap)\n", cell);
+	printf("%9s %11s %6s %6s\n", "op", "heap", "alloc", "frag");
+	for (i = 0; i < s->num; i++){
+		const struct heapmap_snap *hs = &s->snaps[i];
+		double free_bytes = 0, largest = 0;
+		uint64_t j;
+
+		for (j = 0; j < hs->num_runs; j++){
+			if (!HEAPMAP_RUN_ALLOC(s->runs[i][j])){
+				free_bytes += HEAPMAP_RUN_BYTES(s->runs[i][j]);
+				if (HEAPMAP_RUN_BYTES(s->runs[i][j]) > largest)
+					largest = HEAPMAP_RUN_BYTES(s->runs[i][j]);
+			}
+		}
+		printf("%9u %11lu %5.1f%% %5.1f%% |", hs->op, (unsigned long) hs->heap_size,
+			100 * (1 - free_bytes / hs->heap_size),
+			free_bytes > 0 ? 100 * (1 - largest / free_bytes) : 0.0);
+		memset(alloc, 0, sizeof(alloc));
+		memset(bytes, 0, sizeof(bytes));
+		map_row(hs, s->runs[i], alloc, bytes, width, cell);
+		for (c = 0; c < width; c++){
+			if (bytes[c] == 0)
+				putchar(' ');
+			else
+				putchar(ramp[(int) (alloc[c] / bytes[c] * (sizeof(ramp) - 2) + 0.5)]);
+		}
+		printf("|\n");
+	}
+
+	printf("\nFragmentation per region of %.0f bytes, in tenths ('-' no free bytes)\n", region);
+	printf("%9s  ", "op");
+	for (c = 0; c < regions; c++)
+		putchar('0' + c % 10);
+	printf("\n");
+	for (i = 0; i < s->num; i++){
+		const struct heapmap_snap *hs = &s->snaps[i];
+
+		frag_row(hs, s->runs[i], frag, regions, region);
+		printf("%9u |", hs->op);
+		for (c = 0; c < regions; c++){
+			if (c * region >= hs->heap_size)
+				putchar(' ');
+			else if (frag[c] < 0)
+				putchar('-');
+			else
+				putchar('0' + (int) (frag[c] * 10 > 9 ? 9 : frag[c] * 10));
+		}
+		printf("|\n");
+	}
+
+	printf("\nFree blocks per size class\n%9s", "op");
+	for (c = 0; c < MM_SIZE_CLASSES; c++){
+		if (any[c])
+			printf(" %6s%-2d", "2^", c);
+	}
+	printf("\n");
+	for (i = 0; i < s->num; i++){
+		printf("%9u", s->snaps[i].op);
+		for (c = 0; c < MM_SIZE_CLASSES; c++){
+			if (any[c])
+				printf(" %8lu", (unsigned long) s->snaps[i].class_blocks[c]);
+		}
+		printf("\n");
+	}
+}
+
+/*
+ * draw_series - Add the rows of one series to the image in fp, a band
+ * of IMG_ROWS pixel rows per snapshot, and a black row after
+ */
+static void draw_series(FILE *fp, const series *s){
+	double alloc[IMG_WIDTH], bytes[IMG_WIDTH], max_heap = 0, a;
+	unsigned char row[IMG_WIDTH * 3];
+	size_t i;
+	int c, r;
+
+	for (i = 0; i < s->num; i++){
+		if (s->snaps[i].heap_size > max_heap)
+			max_heap = s->snaps[i].heap_size;
+	}
+	for (i = 0; i < s->num; i++){
+		memset(alloc, 0, sizeof(alloc));
+		memset(bytes, 0, sizeof(bytes));
+		map_row(&s->snaps[i], s->runs[i], alloc, bytes, IMG_WIDTH, max_heap / IMG_WIDTH);
+		for (c = 0; c < IMG_WIDTH; c++){
+			a = bytes[c] > 0 ? alloc[c] / bytes[c] : 0;
+			row[3 * c] = bytes[c] > 0 ? 255 - 215 * a : 0;
+			row[3 * c + 1] = bytes[c] > 0 ? 255 - 155 * a : 0;
+			row[3 * c + 2] = bytes[c] > 0 ? 255 - 35 * a : 0;
+		}
+		for (r = 0; r < IMG_ROWS; r++)
+			fwrite(row, 1, sizeof(row), fp);
+	}
+	memset(row, 0, sizeof(row));
+	fwrite(row, 1, sizeof(row), fp);
+}
+
+static void usage(void){
+	fprintf(stderr, "usage: heapmap [-w width] [-r regions] [-a allocator] [-t trace] [-p image] file\n");
+	fprintf(stderr, "  -w width      columns of the heap map (default %d, at most %d)\n", WIDTH, WIDTH * 16);
+	fprintf(stderr, "  -r regions    regions fragmentation is told for (default %d, at most %d)\n",
+		REGIONS, REGIONS * 16);
+	fprintf(stderr, "  -a allocator  only the snapshots of this allocator\n");
+	fprintf(stderr, "  -t trace      only the snapshots of this trace\n");
+	fprintf(stderr, "  -p image      draw the heap maps to this PPM image too\n");
+}
+
+int main(int argc, char **argv){
+	const char *allocator = NULL, *trace = NULL, *image = NULL;
+	int width = WIDTH, regions = REGIONS, c, ret;
+	series *all = NULL;
+	size_t num_series = 0, i, j, rows = 0;
+	struct heapmap_snap hs;
+	uint64_t *runs;
+	FILE *fp;
+
+	while ((c = getopt(argc, argv, "w:r:a:t:p:h")) != -1){
+		switch (c){
+		case 'w':
+			width = atoi(optarg);
+			break;
+		case 'r':
+			regions = atoi(optarg);
+			break;
+		case 'a':
+			allocator = optarg;
+			break;
+		case 't':
+			trace = optarg;
+			break;
+		case 'p':
+			image = optarg;
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+	if (optind != argc - 1 || width < 1 || width > WIDTH * 16
+	    || regions < 1 || regions > REGIONS * 16){
+		usage();
+		return 1;
+	}
+	if ((fp = fopen(argv[optind], "rb")) == NULL){
+		perror(argv[optind]);
+		return 1;
+	}
+
+	/*a new series starts whenever the allocator or the trace changes*/
+	while ((ret = read_snap(fp, &hs, &runs)) > 0){
+		series *s = num_series > 0 ? &all[num_series - 1] : NULL;
+
+		if ((allocator != NULL && strcmp(hs.allocator, allocator) != 0)
+		    || (trace != NULL && strcmp(hs.trace, trace) != 0)){
+			free(runs);
+			continue;
+		}
+		if (s == NULL || strcmp(s->snaps[0].allocator, hs.allocator) != 0
+		    || strcmp(s->snaps[0].trace, hs.trace) != 0 || hs.op <= s->snaps[s->num - 1].op){
+			if ((all = realloc(all, (num_series + 1) * sizeof(series))) == NULL){
+				fprintf(stderr, "heapmap: out of memory\n");
+				return 1;
+			}
+			s = &all[num_series++];
+			memset(s, 0, sizeof(series));
+		}
+		if (s->num == s->max){
+			s->max = s->max ? 2 * s->max : 64;
+			s->snaps = realloc(s->snaps, s->max * sizeof(struct heapmap_snap));
+			s->runs = realloc(s->runs, s->max * sizeof(uint64_t *));
+			if (s->snaps == NULL || s->runs == NULL){
+				fprintf(stderr, "heapmap: out of memory\n");
+				return 1;
+			}
+		}
+		s->snaps[s->num] = hs;
+		s->runs[s->num++] = runs;
+		rows += IMG_ROWS;
+	}
+	fclose(fp);
+	if (ret < 0){
+		fprintf(stderr, "heapmap: %s is not a file of heap snapshots\n", argv[optind]);
+		return 1;
+	}
+	if (num_series == 0){
+		fprintf(stderr, "heapmap: no snapshots in %s\n", argv[optind]);
+		return 1;
+	}
+
+	for (i = 0; i < num_series; i++)
+		print_series(&all[i], width, regions);
+	if (image != NULL){
+		if ((fp = fopen(image, "wb")) == NULL){
+			perror(image);
+			return 1;
+		}
+		fprintf(fp, "P6\n%d %lu\n255\n", IMG_WIDTH, (unsigned long) (rows + num_series));
+		for (i = 0; i < num_series; i++)
+			draw_series(fp, &all[i]);
+		if (fclose(fp) != 0){
+			perror(image);
+			return 1;
+		}
+	}
+	for (i = 0; i < num_series; i++){
+		for (j = 0; j < all[i].num; j++)
+			free(all[i].runs[j]);
+		free(all[i].snaps);
+		free(all[i].runs);
+	}
+	free(all);
+	return 0;
+}
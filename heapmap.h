@@ -0,0 +1,45 @@
+/*
+ * heapmap.h - Format of the heap snapshots mdriver -m writes and
+ * heapmap reads
+ *
+ * A file is a sequence of snapshots, each a heapmap_snap followed by
+ * num_runs run words. The heap is described from its first block to
+ * its epilogue as runs, in address order: a free block is a run of its
+ * own (free blocks never touch, they are coalesced), and allocated
+ * blocks next to each other make one run. A run word is its bytes
+ * shifted left by one, or'ed with 1 if the run is allocated. The words
+ * are in the byte order of the machine that wrote them, which is also
+ * the one meant to read them.
+ */
+#ifndef __HEAPMAP_H__
+#define __HEAPMAP_H__
+
+#include <stdint.h>
+
+#include "mm.h"
+
+#define HEAPMAP_MAGIC   0x50414d48 /*"HMAP"*/
+#define HEAPMAP_VERSION 1
+#define HEAPMAP_NAME    32 /*bytes of an allocator or trace name, NUL included*/
+
+#define HEAPMAP_RUN(bytes, alloc) ((uint64_t) (bytes) << 1 | ((alloc) != 0))
+#define HEAPMAP_RUN_BYTES(run)    ((run) >> 1)
+#define HEAPMAP_RUN_ALLOC(run)    ((run) & 1)
+
+/*the heap after op of a trace replayed on an allocator*/
+struct heapmap_snap {
+	uint32_t magic;
+	uint32_t version;
+	char allocator[HEAPMAP_NAME];
+	char trace[HEAPMAP_NAME];
+	uint32_t op;             /*operations replayed so far*/
+	uint32_t num_ops;        /*operations in the trace*/
+	uint64_t heap_size;      /*bytes of heap, list heads and prologue included*/
+	uint64_t first;          /*offset of the first block into the heap*/
+	uint64_t alloc_blocks;   /*allocated blocks*/
+	uint64_t num_runs;       /*run words that follow*/
+	uint64_t class_blocks[MM_SIZE_CLASSES]; /*free blocks per size class, from mm_stats*/
+	uint64_t class_bytes[MM_SIZE_CLASSES];  /*free bytes per size class*/
+};
+
+#endif /* __HEAPMAP_H__ */
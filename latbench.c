@@ -0,0 +1,191 @@
+/*
+ * latbench.c - Latency distribution benchmark for malloc and free
+ *
+ * Runs a random sequence of operations on a table of slots, like a
+ * thread of mtbench: an empty slot gets a new block, a full slot has its
+ * block freed. Most blocks are small, some are a few KB and a few are
+ * large enough to get a mapping of their own from the allocators that
+ * make them. Every malloc and free is timed on its own, from right after
+ * mm_init, so the heap growing, trims and mappings are all in, and the
+ * distribution of the times is printed: mean, percentiles and the max,
+ * which is what a caller with a deadline has to plan for. The times
+ * include reading the clock twice, some 30 ns. The run is repeated and
+ * each column is the lowest of the repeats, so an interrupt that hits
+ * one run does not pass for the allocator's worst case, while a slow
+ * path the allocator takes at the same point of every run still shows.
+ *
+ * It is run with the segregated list allocator, with the two level
+ * segregated fit index (tlsf), and with that index and bounded latency
+ * on a pool made by mm_init (tlsf-rt).
+ *
+ * usage: latbench [-n ops] [-r repeats]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "mm.h"
+#include "memlib.h"
+
+extern const struct mm_ops seg_mm_ops, tlsf_mm_ops, rt_mm_ops;
+
+static const struct mm_ops *allocators[] = {
+	&seg_mm_ops,
+	&tlsf_mm_ops,
+	&rt_mm_ops,
+};
+
+#define NUM_ALLOCATORS (sizeof(allocators) / sizeof(allocators[0]))
+
+#define SLOTS   4096 /*blocks held at once*/
+#define COLUMNS 6    /*mean, p50, p99, p99.9, p99.99 and max*/
+
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+
+static unsigned long long rnd(unsigned long long *state){
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static inline unsigned long long now_ns(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cmp_lat(const void *a, const void *b){
+	unsigned x = *(const unsigned *) a, y = *(const unsigned *) b;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * run - Run n operations on one allocator, storing the nanoseconds of
+ * each malloc in lat_malloc and of each free in lat_free, and their
+ * counts in *nm and *nf. Returns 0, or -1 if a malloc failed or the
+ * heap is broken.
+ */
+static int run(const struct mm_ops *mm, long n, unsigned *lat_malloc, long *nm,
+		unsigned *lat_free, long *nf){
+	static unsigned char *slot[SLOTS];
+	unsigned long long seed = 0x9E3779B97F4A7C15ULL, t;
+	size_t size;
+	long i;
+	int s;
+
+	mem_reset_brk();
+	if (mm->init() < 0)
+		return -1;
+	memset(slot, 0, sizeof(slot));
+	*nm = *nf = 0;
+	for (i = 0; i < n; i++){
+		unsigned long long r = rnd(&seed);
+
+		s = r % SLOTS;
+		if (slot[s] == NULL){
+			r >>= 16;
+			if (r % 1000 < 900)
+				size = 16 + (r >> 10) % 241;
+			else if (r % 1000 < 990)
+				size = 256 + (r >> 10) % 7937;
+			else
+				size = 8192 + (r >> 10) % (256 * 1024 - 8192 + 1);
+			t = now_ns();
+			slot[s] = mm->malloc(size);
+			lat_malloc[(*nm)++] = now_ns() - t;
+			if (slot[s] == NULL)
+				return -1;
+			slot[s][0] = slot[s][size - 1] = 1;
+		}
+		else{
+			t = now_ns();
+			mm->free(slot[s]);
+			lat_free[(*nf)++] = now_ns() - t;
+			slot[s] = NULL;
+		}
+	}
+	for (s = 0; s < SLOTS; s++)
+		mm->free(slot[s]);
+	return mm->checkheap(0) ? -1 : 0;
+}
+
+/*
+ * dist - Sort the n latencies in lat and lower each column of d, the
+ * mean and the percentiles up to the max, to what they give
+ */
+static void dist(double *d, unsigned *lat, long n){
+	double col[COLUMNS], sum = 0;
+	long i;
+	int k;
+
+	if (n == 0)
+		return;
+	qsort(lat, n, sizeof(unsigned), cmp_lat);
+	for (i = 0; i < n; i++)
+		sum += lat[i];
+	col[0] = sum / n;
+	col[1] = lat[n / 2];
+	col[2] = lat[n * 99 / 100];
+	col[3] = lat[n * 999 / 1000];
+	col[4] = lat[n * 9999 / 10000];
+	col[5] = lat[n - 1];
+	for (k = 0; k < COLUMNS; k++)
+		d[k] = d[k] < 0 ? col[k] : MIN(d[k], col[k]);
+}
+
+static void print_dist(const char *name, const char *op, long n, const double *d){
+	printf("%-10s %-6s %9ld %8.1f %8.0f %8.0f %8.0f %8.0f %10.0f\n", name, op, n,
+		d[0], d[1], d[2], d[3], d[4], d[5]);
+}
+
+int main(int argc, char **argv){
+	long n = 1000000, nm = 0, nf = 0;
+	unsigned *lat_malloc, *lat_free;
+	double d_malloc[COLUMNS], d_free[COLUMNS];
+	int repeats = 5, r, k, c;
+	size_t j;
+
+	while ((c = getopt(argc, argv, "n:r:h")) != -1){
+		switch (c){
+		case 'n':
+			n = atol(optarg);
+			break;
+		case 'r':
+			repeats = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: latbench [-n ops] [-r repeats]\n");
+			return 1;
+		}
+	}
+	if (n <= 0 || (lat_malloc = malloc(n * sizeof(unsigned))) == NULL
+	    || (lat_free = malloc(n * sizeof(unsigned))) == NULL){
+		fprintf(stderr, "latbench: out of memory\n");
+		return 1;
+	}
+
+	mem_init();
+	printf("%-10s %-6s %9s %8s %8s %8s %8s %8s %10s\n", "allocator", "op", "calls",
+		"mean ns", "p50", "p99", "p99.9", "p99.99", "max");
+	for (j = 0; j < NUM_ALLOCATORS; j++){
+		for (k = 0; k < COLUMNS; k++)
+			d_malloc[k] = d_free[k] = -1;
+		for (r = 0; r < repeats; r++){ /*the same operations every time*/
+			if (run(allocators[j], n, lat_malloc, &nm, lat_free, &nf) < 0){
+				printf("%-10s %s\n", allocators[j]->name, "FAILED");
+				return 1;
+			}
+			dist(d_malloc, lat_malloc, nm);
+			dist(d_free, lat_free, nf);
+		}
+		print_dist(allocators[j]->name, "malloc", nm, d_malloc);
+		print_dist(allocators[j]->name, "free", nf, d_free);
+	}
+	mem_deinit();
+	return 0;
+}
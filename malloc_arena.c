@@ -0,0 +1,756 @@
+/*
+ * malloc_arena.c - Segregated list allocator with an arena per thread
+ *
+ * Every thread allocates from an arena of its own: heaps, segregated free
+ * lists and counters like those of malloc_lab.c that no other thread
+ * touches, so malloc, and free of a block of the thread's own arena, take
+ * no lock at all. A block freed by any other thread is pushed on the remote
+ * free stack of the arena it came from, a lock free stack that any number of
+ * threads push on with a compare and swap and that only the owner empties,
+ * taking the whole stack with one exchange; the owner frees those blocks in
+ * one batch at the start of its next malloc. A producer thread handing its
+ * blocks to a consumer thread to free thus never waits on a lock, and the
+ * two only share the cache line of the stack top.
+ *
+ * The first arena (main_arena) lives on the mem_sbrk heap, so a single
+ * threaded program gets the one heap malloc_lab.c would. Every other arena
+ * lives on heaps of ARENA_HEAP bytes mapped with mem_map_aligned, a new one
+ * whenever none of its heaps has room, each aligned to its size and starting
+ * with a heap header naming its arena: the arena of a block is found by
+ * masking its address. Each heap has a prologue and an epilogue of its own,
+ * so blocks never coalesce across heaps. Requests of MMAP_THRESHOLD bytes or
+ * more get a mapping of their own, as in malloc_lab.c, and whichever thread
+ * frees them unmaps them.
+ *
+ * A thread takes an arena the first time it allocates: one given up by a
+ * thread that has exited, if there is any, else a new one. The list of
+ * arenas only grows and is guarded by arena_lock, which nothing else takes.
+ * Blocks freed to an arena without an owner wait on its stack for the next
+ * thread that takes it.
+ *
+ * The blocks are malloc_lab.c's, from mm_block.h: a 4 byte header (size |
+ * MMAPPED | PREV_ALLOC | ALLOC), and for a free block a footer and the next
+ * and previous links of its list, split, coalesced and searched by the
+ * same code with the state of an arena passed in. A block on a remote free
+ * stack stays marked allocated, so nothing coalesces with it, and is linked
+ * through its first payload word. The lists are malloc_lab.c's 12 powers of
+ * two with a bitmap of the non-empty ones.
+ *
+ * mm_init, mm_checkheap, mm_stats and mm_heap_walk are meant to be called
+ * while no other thread uses the allocator.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "mm_block.h"
+
+#define CHUNKSIZE   (1 << 12) /*least bytes the main arena's heap grows by*/
+#define ARENA_HEAP  (1 << 20) /*bytes of a mapped heap, and its alignment*/
+#define HEAP_HDR_SIZE 64 /*heap header, padded to a cache line*/
+#define MMAP_THRESHOLD (128 * 1024) /*requests this big get a mapping of their own*/
+
+/*
+ * The prev allocated bit of an allocated block's header changes with its
+ * neighbours, in the owner's thread, while the thread freeing the block
+ * reads the rest of the header: both go through relaxed atomics.
+ */
+#define LOAD_HDR(bp)         __atomic_load_n((unsigned *) HDRP(bp), __ATOMIC_RELAXED)
+#define STORE_HDR(bp, val)   __atomic_store_n((unsigned *) HDRP(bp), (val), __ATOMIC_RELAXED)
+#define IS_MAPPED(bp)        (LOAD_HDR(bp) & MMAPPED)
+/*first block of the main arena's heap, and of mapped heap h, whose oldest heap holds the arena*/
+#define MAIN_FIRST           ((char *) main_arena + sizeof(arena_t) + 4 * WSIZE)
+#define HEAP_FIRST(h)        ((h) + HEAP_HDR_SIZE + (((heap_hdr_t *) (h))->next == NULL ? sizeof(arena_t) : 0) \
+				+ 4 * WSIZE)
+
+/*an arena: the free lists of its heaps, and the stack other threads free to*/
+typedef struct arena {
+	char *heads[SEG_LISTS];        /*first block of each list*/
+	size_t nonempty;               /*bit i set iff list i is not empty*/
+	char *heaps;                   /*newest mapped heap, NULL for the main arena*/
+	struct arena *next;            /*next arena of the list of all arenas*/
+	int owned;                     /*a live thread allocates from it*/
+	struct mm_heap_stats stats;    /*free bytes and blocks per class, splits and so on*/
+	char *remote __attribute__((aligned(64))); /*top of the remote free stack, on a line of its own*/
+} arena_t;
+
+/*the start of a mapped heap*/
+typedef struct {
+	arena_t *arena;                /*arena the heap belongs to*/
+	char *next;                    /*next older heap of the arena*/
+} heap_hdr_t;
+
+static arena_t *main_arena;        /*the arena on the mem_sbrk heap, first of the list*/
+static unsigned long arena_epoch;  /*mm_init calls so far, arenas of an older one are gone*/
+static size_t heap_bytes;          /*bytes of all heaps, mem_sbrk heap included*/
+static size_t meta_bytes;          /*bytes of arenas, heap headers, prologues and epilogues*/
+static size_t peak_heap;
+static struct mm_heap_stats mapped_stats; /*mapped bytes and blocks of the large blocks*/
+static pthread_mutex_t arena_lock = PTHREAD_MUTEX_INITIALIZER; /*guards the list and the owned flags*/
+static pthread_key_t arena_key;    /*only used to give the arena up at thread exit*/
+static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+static __thread arena_t *my_arena; /*arena of this thread, if my_epoch is arena_epoch*/
+static __thread unsigned long my_epoch;
+
+static arena_t *thread_arena(void);
+static arena_t *arena_take(void);
+static arena_t *arena_new(void);
+static void arena_make_key(void);
+static void arena_release(void *arg);
+static arena_t *arena_of(const char *bp);
+static void remote_push(arena_t *a, char *bp);
+static void remote_drain(arena_t *a);
+static char *heap_map(arena_t *a, size_t arena_size);
+static char *grow(arena_t *a, size_t asize);
+static void note_heap(size_t bytes);
+static char *alloc_block(arena_t *a, size_t asize);
+static void free_block(arena_t *a, char *bp);
+static size_t adjust_size(size_t size);
+static void *large_realloc(void *oldptr, size_t size);
+static void walk_heap(char *bp, void (*visit)(void *arg, void *bp, size_t size, int alloc), void *arg);
+static int check_heap(arena_t *a, char *bp, size_t *free_blocks, struct mm_heap_stats *st, int verbose);
+static int check_arena(arena_t *a, int verbose);
+
+/*
+ * The functions on blocks of mm_block.h, block_place, block_coalesce and
+ * so on, as in malloc_lab.c but on the lists and counters of the arena
+ * passed first. Only the owner changes the blocks of an arena, but a
+ * thread freeing a block reads its header, so the header of the block
+ * after a changed one goes through LOAD_HDR and STORE_HDR.
+ */
+#define BLOCK_HEAP          arena_t *a,
+#define BLOCK_HEAP_ARG      a,
+#define BLOCK_STATS         a->stats
+#define BLOCK_MAPPED        mapped_stats
+#define LIST_HEAD(i)        a->heads[i]
+#define LIST_BITMAP         a->nonempty
+#define BLOCK_LOAD_HDR(bp)  LOAD_HDR(bp)
+#define BLOCK_STORE_HDR(bp, val) STORE_HDR(bp, val)
+#include "mm_block.h"
+
+/*
+ * mm_init - Forget every arena and lay out the main arena on an empty
+ * mem_sbrk heap: the arena, a padding word, the prologue and epilogue
+ */
+int mm_init(void){
+	char *p;
+
+	arena_epoch++;
+	heap_bytes = 0;
+	memset(&mapped_stats, 0, sizeof(mapped_stats));
+	if ((p = mem_sbrk(sizeof(arena_t) + 4 * WSIZE)) == (void *) -1){
+		return -1;
+	}
+	main_arena = (arena_t *) p;
+	memset(main_arena, 0, sizeof(arena_t));
+	p += sizeof(arena_t);
+	PUT_4(p, 0); /*padding*/
+	PUT_4(p + WSIZE, PACK(DSIZE, ALLOC)); /*prologue header*/
+	PUT_4(p + 2 * WSIZE, PACK(DSIZE, ALLOC)); /*prologue footer*/
+	PUT_4(p + 3 * WSIZE, PACK(0, PREV_ALLOC | ALLOC)); /*epilogue*/
+	meta_bytes = sizeof(arena_t) + 4 * WSIZE;
+	heap_bytes = peak_heap = mem_heapsize();
+	if (grow(main_arena, CHUNKSIZE) == NULL){
+		return -1;
+	}
+	return 0;
+}
+
+void *mm_malloc(size_t size){
+	arena_t *a;
+
+	if (size == 0){
+		return NULL;
+	}
+	if (size >= MMAP_THRESHOLD){
+		return block_map(DSIZE, size);
+	}
+	if ((a = thread_arena()) == NULL){
+		return NULL;
+	}
+	if (__atomic_load_n(&a->remote, __ATOMIC_RELAXED) != NULL){
+		remote_drain(a);
+	}
+	return alloc_block(a, adjust_size(size));
+}
+
+/*
+ * mm_free - Free bp to this thread's arena if it came from it, else push
+ * it on the remote free stack of the arena it came from
+ */
+void mm_free(void *bp){
+	arena_t *a;
+
+	if (bp == NULL){
+		return;
+	}
+	if (IS_MAPPED(bp)){
+		block_unmap(bp);
+		return;
+	}
+	a = arena_of(bp);
+	if (a == my_arena && my_epoch == arena_epoch){
+		free_block(a, bp);
+	}
+	else{
+		remote_push(a, bp);
+	}
+}
+
+/*
+ * mm_realloc - Resize a block of this thread's arena in place if it can,
+ * shrinking it or growing it into the free block after it. A block of
+ * another arena cannot be split or merged from here, so it is only kept
+ * if it is big enough already, and otherwise moved.
+ */
+void *mm_realloc(void *ptr, size_t size){
+	size_t asize, have, more;
+	char *next, *newptr;
+	arena_t *a;
+
+	if (ptr == NULL){
+		return mm_malloc(size);
+	}
+	if (size == 0){
+		mm_free(ptr);
+		return NULL;
+	}
+	if (IS_MAPPED(ptr)){
+		return large_realloc(ptr, size);
+	}
+	asize = adjust_size(size);
+	have = LOAD_HDR(ptr) & ~0x7;
+	a = arena_of(ptr);
+	if (size < MMAP_THRESHOLD && a == my_arena && my_epoch == arena_epoch){
+		if (asize <= have){
+			block_shrink(a, ptr, asize);
+			return ptr;
+		}
+		next = NEXT_BLKP(ptr);
+		more = GET_ALLOC(HDRP(next)) ? 0 : GET_SIZE(HDRP(next));
+		if (have + more >= asize){
+			block_rem_free(a, next, more);
+			block_set_alloc(ptr, have + more);
+			block_shrink(a, ptr, asize);
+			return ptr;
+		}
+	}
+	else if (size < MMAP_THRESHOLD && asize <= have){
+		return ptr;
+	}
+	if ((newptr = mm_malloc(size)) == NULL){
+		return NULL;
+	}
+	memcpy(newptr, ptr, MIN(size, have - WSIZE));
+	mm_free(ptr);
+	return newptr;
+}
+
+void *mm_calloc(size_t nmemb, size_t size){
+	size_t bytes;
+	void *bp;
+
+	if (__builtin_mul_overflow(nmemb, size, &bytes) || (bp = mm_malloc(bytes)) == NULL){
+		return NULL;
+	}
+	if (!IS_MAPPED(bp)){ /*mappings come zero filled*/
+		memset(bp, 0, bytes);
+	}
+	return bp;
+}
+
+/*
+ * mm_memalign - A block of size bytes aligned to align bytes, cut out of
+ * a block big enough to hold one, with the slack in front of it given
+ * back as a free block. NULL for a size of 0, as in malloc_lab.c.
+ */
+void *mm_memalign(size_t align, size_t size){
+	size_t total, lead;
+	char *bp, *abp;
+	arena_t *a;
+
+	if (size == 0 || (align & (align - 1)) != 0){
+		return NULL;
+	}
+	if (align <= DSIZE){
+		return mm_malloc(size);
+	}
+	if (size > SIZE_MAX / 2 || align > SIZE_MAX / 4){
+		return NULL;
+	}
+	if (size + align + MIN_BLOCK_SIZE >= MMAP_THRESHOLD){
+		return block_map(align, size);
+	}
+	if ((bp = mm_malloc(size + align + MIN_BLOCK_SIZE)) == NULL){
+		return NULL;
+	}
+	a = my_arena; /*mm_malloc took one*/
+	abp = bp;
+	if ((size_t) bp % align != 0){
+		abp = (char *) (((size_t) bp + MIN_BLOCK_SIZE + align - 1) & ~(align - 1));
+		total = GET_SIZE(HDRP(bp));
+		lead = abp - bp;
+		PUT_4(HDRP(abp), PACK(total - lead, ALLOC));
+		block_set_alloc(abp, total - lead);
+		block_set_free(bp, lead);
+		a->stats.splits++;
+		block_coalesce(a, bp);
+	}
+	block_shrink(a, abp, adjust_size(size));
+	return abp;
+}
+
+int mm_posix_memalign(void **memptr, size_t alignment, size_t size){
+	void *bp;
+
+	if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0){
+		return EINVAL;
+	}
+	if (size == 0){
+		*memptr = NULL;
+		return 0;
+	}
+	if ((bp = mm_memalign(alignment, size)) == NULL){
+		return ENOMEM;
+	}
+	*memptr = bp;
+	return 0;
+}
+
+void *mm_aligned_alloc(size_t alignment, size_t size){
+	return mm_memalign(alignment, size);
+}
+
+size_t mm_malloc_usable_size(void *bp){
+	if (bp == NULL){
+		return 0;
+	}
+	if (IS_MAPPED(bp)){
+		return MMAP_LEN(bp) - MMAP_LEAD(bp);
+	}
+	return (LOAD_HDR(bp) & ~0x7) - WSIZE;
+}
+
+/*
+ * mm_stats - The counters of all arenas added up. Blocks waiting on
+ * remote free stacks count as allocated.
+ */
+void mm_stats(struct mm_heap_stats *st){
+	arena_t *a;
+	size_t i;
+
+	memset(st, 0, sizeof(*st));
+	for (a = main_arena; a != NULL; a = a->next){
+		for (i = 0; i < MM_SIZE_CLASSES; i++){
+			st->class_bytes[i] += a->stats.class_bytes[i];
+			st->class_blocks[i] += a->stats.class_blocks[i];
+			st->free_bytes += a->stats.class_bytes[i];
+			st->free_blocks += a->stats.class_blocks[i];
+		}
+		st->splits += a->stats.splits;
+		st->coalesces += a->stats.coalesces;
+		st->extends += a->stats.extends;
+	}
+	st->heap_size = heap_bytes;
+	st->peak_heap = peak_heap;
+	st->alloc_bytes = st->heap_size - st->free_bytes - meta_bytes;
+	st->mapped_bytes = mapped_stats.mapped_bytes;
+	st->mapped_blocks = mapped_stats.mapped_blocks;
+}
+
+void mm_heap_walk(void (*visit)(void *arg, void *bp, size_t size, int alloc), void *arg){
+	arena_t *a;
+	char *h;
+
+	walk_heap(MAIN_FIRST, visit, arg);
+	for (a = main_arena; a != NULL; a = a->next){
+		for (h = a->heaps; h != NULL; h = ((heap_hdr_t *) h)->next){
+			walk_heap(HEAP_FIRST(h), visit, arg);
+		}
+	}
+}
+
+/*
+ * mm_checkheap - Check every heap of every arena block by block, every
+ * free list, that each free block is on the right list of its own arena
+ * exactly once, each arena's counters, and that every block on a remote
+ * free stack is an allocated block of that arena. Returns 0, or 1 on an
+ * error.
+ */
+int mm_checkheap(int verbose){
+	arena_t *a;
+
+	for (a = main_arena; a != NULL; a = a->next){
+		if (check_arena(a, verbose)){
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Arenas
+ * ------
+ */
+
+/*
+ * thread_arena - This thread's arena, taken on its first call since
+ * mm_init. NULL if there is none to take and no memory for a new one.
+ */
+static arena_t *thread_arena(void){
+	if (my_arena == NULL || my_epoch != arena_epoch){
+		my_arena = arena_take();
+		my_epoch = arena_epoch;
+	}
+	return my_arena;
+}
+
+/*
+ * arena_take - Take an arena without an owner, or make a new one, and
+ * arrange for it to be given up when this thread exits
+ */
+static arena_t *arena_take(void){
+	arena_t *a, *last = NULL;
+
+	pthread_once(&arena_once, arena_make_key);
+	pthread_mutex_lock(&arena_lock);
+	for (a = main_arena; a != NULL && a->owned; a = a->next){
+		last = a;
+	}
+	if (a == NULL && (a = arena_new()) != NULL){
+		last->next = a;
+	}
+	if (a != NULL){
+		a->owned = 1;
+	}
+	pthread_mutex_unlock(&arena_lock);
+	pthread_setspecific(arena_key, a);
+	return a;
+}
+
+/*
+ * arena_new - A new arena, on its first mapped heap. Called with
+ * arena_lock held.
+ */
+static arena_t *arena_new(void){
+	char *h, *bp;
+	arena_t *a;
+
+	if ((h = mem_map_aligned(ARENA_HEAP, ARENA_HEAP)) == NULL){
+		return NULL;
+	}
+	a = (arena_t *) (h + HEAP_HDR_SIZE);
+	memset(a, 0, sizeof(arena_t));
+	((heap_hdr_t *) h)->arena = a;
+	((heap_hdr_t *) h)->next = NULL;
+	a->heaps = h;
+	bp = heap_map(a, sizeof(arena_t));
+	a->stats.extends++;
+	block_add_free(a, bp, GET_SIZE(HDRP(bp)));
+	return a;
+}
+
+static void arena_make_key(void){
+	pthread_key_create(&arena_key, arena_release);
+}
+
+/*
+ * arena_release - Thread exit handler, free what other threads freed to
+ * the thread's arena and give the arena up for another thread to take
+ */
+static void arena_release(void *arg){
+	arena_t *a = (arena_t *) arg;
+
+	if (my_arena != a || my_epoch != arena_epoch){
+		return; /*gone with an mm_init since*/
+	}
+	remote_drain(a);
+	pthread_mutex_lock(&arena_lock);
+	a->owned = 0;
+	pthread_mutex_unlock(&arena_lock);
+	my_arena = NULL;
+}
+
+/*
+ * arena_of - The arena of a block that is not mapped on its own: the main
+ * arena if it lies in the mem_sbrk heap, else the one its heap header names
+ */
+static arena_t *arena_of(const char *bp){
+	if ((size_t) (bp - (char *) mem_heap_lo()) < MAX_HEAP){
+		return main_arena;
+	}
+	return ((heap_hdr_t *) ((size_t) bp & ~(size_t) (ARENA_HEAP - 1)))->arena;
+}
+
+/*
+ * remote_push - Put the allocated block bp of arena a, freed by a thread
+ * that does not own a, on a's remote free stack
+ */
+static void remote_push(arena_t *a, char *bp){
+	char *top = __atomic_load_n(&a->remote, __ATOMIC_RELAXED);
+
+	do {
+		PUT(bp, (size_t) top);
+	} while (!__atomic_compare_exchange_n(&a->remote, &top, bp, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/*
+ * remote_drain - Take a's whole remote free stack and free its blocks.
+ * Only the owner of a calls this, and taking the whole stack at once means
+ * no block on it can be popped and pushed back in between (no ABA).
+ */
+static void remote_drain(arena_t *a){
+	char *bp = __atomic_exchange_n(&a->remote, NULL, __ATOMIC_ACQUIRE);
+	char *next;
+
+	for (; bp != NULL; bp = next){
+		next = (char *) GET(bp);
+		free_block(a, bp);
+	}
+}
+
+/*
+ * Heaps
+ * -----
+ */
+
+/*
+ * heap_map - Lay out the mapped heap a->heaps, whose header is written
+ * and which holds the arena itself after the header if arena_size is not
+ * 0: a padding word, the prologue, one free block and the epilogue.
+ * Returns the free block, on no list yet.
+ */
+static char *heap_map(arena_t *a, size_t arena_size){
+	char *p = a->heaps + HEAP_HDR_SIZE + arena_size;
+	char *bp = p + 4 * WSIZE;
+	size_t size = ARENA_HEAP - (bp - a->heaps);
+
+	PUT_4(p, 0); /*padding*/
+	PUT_4(p + WSIZE, PACK(DSIZE, ALLOC)); /*prologue header*/
+	PUT_4(p + 2 * WSIZE, PACK(DSIZE, ALLOC)); /*prologue footer*/
+	PUT_4(HDRP(bp), PACK(size, PREV_ALLOC));
+	PUT_4(FTRP(bp), PACK(size, PREV_ALLOC));
+	PUT_4(HDRP(NEXT_BLKP(bp)), PACK(0, ALLOC)); /*epilogue*/
+	__atomic_add_fetch(&meta_bytes, ARENA_HEAP - size, __ATOMIC_RELAXED);
+	note_heap(__atomic_add_fetch(&heap_bytes, ARENA_HEAP, __ATOMIC_RELAXED));
+	return bp;
+}
+
+/*
+ * grow - Give arena a a free block of at least asize bytes: the main
+ * arena's heap grows by what its last block is short of, merging the
+ * two, another arena gets a new mapped heap. Returns the block, on its
+ * list, or NULL.
+ */
+static char *grow(arena_t *a, size_t asize){
+	char *bp, *last, *h;
+	size_t size;
+
+	if (a == main_arena){
+		last = (char *) mem_heap_hi() + 1;
+		size = GET_PREV_ALLOC(HDRP(last)) ? asize : asize - GET_SIZE(last - DSIZE);
+		size = MAX(size, CHUNKSIZE);
+		if ((bp = block_extend(a, size)) == NULL){
+			return NULL;
+		}
+		note_heap(__atomic_add_fetch(&heap_bytes, size, __ATOMIC_RELAXED));
+		return bp;
+	}
+	if ((h = mem_map_aligned(ARENA_HEAP, ARENA_HEAP)) == NULL){
+		return NULL;
+	}
+	((heap_hdr_t *) h)->arena = a;
+	((heap_hdr_t *) h)->next = a->heaps;
+	a->heaps = h;
+	bp = heap_map(a, 0);
+	a->stats.extends++;
+	block_add_free(a, bp, GET_SIZE(HDRP(bp)));
+	return bp;
+}
+
+/*
+ * note_heap - Raise the peak heap size to bytes if it is below
+ */
+static void note_heap(size_t bytes){
+	size_t peak = __atomic_load_n(&peak_heap, __ATOMIC_RELAXED);
+
+	while (bytes > peak && !__atomic_compare_exchange_n(&peak_heap, &peak, bytes, 1,
+		__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+}
+
+/*
+ * Blocks of an arena, touched by its owner only
+ * ---------------------------------------------
+ */
+
+/*
+ * alloc_block - Allocate a block of asize bytes from arena a
+ */
+static char *alloc_block(arena_t *a, size_t asize){
+	char *bp;
+
+	if ((bp = block_find_fit(a, asize)) == NULL && (bp = grow(a, asize)) == NULL){
+		return NULL;
+	}
+	block_place(a, bp, asize);
+	return bp;
+}
+
+/*
+ * free_block - Free the allocated block bp of arena a
+ */
+static void free_block(arena_t *a, char *bp){
+	block_set_free(bp, GET_SIZE(HDRP(bp)));
+	block_coalesce(a, bp);
+}
+
+/*
+ * adjust_size - Block size for a request of size bytes
+ */
+static size_t adjust_size(size_t size){
+	return MAX((size + WSIZE + DSIZE - 1) & ~(size_t) (DSIZE - 1), MIN_BLOCK_SIZE);
+}
+
+/*
+ * Large blocks
+ * ------------
+ * Blocks with mappings of their own, those of mm_block.h (block_map,
+ * block_unmap and block_remap) as in malloc_lab.c.
+ */
+
+/*
+ * large_realloc - Resize a mapped block with block_remap, or copy it to
+ * an arena if it gets small enough for one
+ */
+static void *large_realloc(void *oldptr, size_t size){
+	char *newptr;
+
+	if (size < MMAP_THRESHOLD){
+		if ((newptr = mm_malloc(size)) == NULL){
+			return NULL;
+		}
+		memcpy(newptr, oldptr, size);
+		block_unmap(oldptr);
+		return newptr;
+	}
+	return block_remap(oldptr, size);
+}
+
+/*
+ * Heap walk and consistency checks
+ * --------------------------------
+ */
+
+/*
+ * walk_heap - Visit the blocks of one heap, from its first block bp
+ */
+static void walk_heap(char *bp, void (*visit)(void *arg, void *bp, size_t size, int alloc), void *arg){
+	for (; GET_SIZE(HDRP(bp)) != 0; bp = NEXT_BLKP(bp)){
+		visit(arg, bp, GET_SIZE(HDRP(bp)), GET_ALLOC(HDRP(bp)) != 0);
+	}
+}
+
+/*
+ * check_heap - Check the blocks of one heap of a, from its first block
+ * bp to its epilogue, and add up its free blocks per size class in st
+ */
+static int check_heap(arena_t *a, char *bp, size_t *free_blocks, struct mm_heap_stats *st, int verbose){
+	int prev_free = 0;
+	size_t size;
+
+	for (; (size = GET_SIZE(HDRP(bp))) != 0; bp = NEXT_BLKP(bp)){
+		if (verbose){
+			printf("%p: %lu bytes %s\n", bp, (unsigned long) size, GET_ALLOC(HDRP(bp)) ? "allocated" : "free");
+		}
+		if ((size_t) bp % DSIZE != 0 || size < MIN_BLOCK_SIZE || size % DSIZE != 0 || arena_of(bp) != a){
+			printf("Block %p is misaligned, has a bad size of %lu or is in another arena\n",
+				bp, (unsigned long) size);
+			return 1;
+		}
+		if ((GET_PREV_ALLOC(HDRP(bp)) == 0) != prev_free){
+			printf("Block %p has a wrong prev allocated bit\n", bp);
+			return 1;
+		}
+		if (!GET_ALLOC(HDRP(bp))){
+			if (GET_4(HDRP(bp)) != GET_4(FTRP(bp))){
+				printf("Free block %p: header and footer mismatch\n", bp);
+				return 1;
+			}
+			if (prev_free){
+				printf("Free blocks before %p are not coalesced\n", bp);
+				return 1;
+			}
+			st->class_bytes[MM_SIZE_CLASS(size)] += size;
+			st->class_blocks[MM_SIZE_CLASS(size)]++;
+			(*free_blocks)++;
+		}
+		prev_free = !GET_ALLOC(HDRP(bp));
+	}
+	if (!GET_ALLOC(HDRP(bp)) || (GET_PREV_ALLOC(HDRP(bp)) == 0) != prev_free){
+		printf("Bad epilogue header at %p\n", HDRP(bp));
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * check_arena - Check the heaps, lists, counters and remote free stack
+ * of arena a
+ */
+static int check_arena(arena_t *a, int verbose){
+	struct mm_heap_stats st;
+	size_t i, free_blocks = 0, listed = 0;
+	char *bp, *prev, *h;
+
+	memset(&st, 0, sizeof(st));
+	if (a == main_arena && check_heap(a, MAIN_FIRST, &free_blocks, &st, verbose)){
+		return 1;
+	}
+	for (h = a->heaps; h != NULL; h = ((heap_hdr_t *) h)->next){
+		if ((size_t) h % ARENA_HEAP != 0 || ((heap_hdr_t *) h)->arena != a){
+			printf("Heap %p is misaligned or belongs to another arena\n", h);
+			return 1;
+		}
+		if (check_heap(a, HEAP_FIRST(h), &free_blocks, &st, verbose)){
+			return 1;
+		}
+	}
+	for (i = 0; i < SEG_LISTS; i++){
+		if ((a->heads[i] != NULL) != ((a->nonempty >> i) & 1)){
+			printf("The bitmap bit of list %lu does not match the list\n", (unsigned long) i);
+			return 1;
+		}
+		for (prev = NULL, bp = a->heads[i]; bp != NULL; prev = bp, bp = GET_NEXT_FREE(bp)){
+			if (++listed > free_blocks || GET_ALLOC(HDRP(bp)) || GET_PREV_FREE(bp) != prev
+			    || seg_index(GET_SIZE(HDRP(bp))) != i || arena_of(bp) != a){
+				printf("Free block %p is allocated, linked wrong or on the wrong list\n", bp);
+				return 1;
+			}
+		}
+	}
+	if (listed != free_blocks){
+		printf("%lu free blocks in the heaps, %lu on the lists\n",
+			(unsigned long) free_blocks, (unsigned long) listed);
+		return 1;
+	}
+	for (i = 0; i < MM_SIZE_CLASSES; i++){
+		if (st.class_bytes[i] != a->stats.class_bytes[i] || st.class_blocks[i] != a->stats.class_blocks[i]){
+			printf("Error: size class %lu has %lu free blocks of %lu bytes, the counters say %lu of %lu\n",
+				(unsigned long) i, (unsigned long) st.class_blocks[i], (unsigned long) st.class_bytes[i],
+				(unsigned long) a->stats.class_blocks[i], (unsigned long) a->stats.class_bytes[i]);
+			return 1;
+		}
+	}
+	for (bp = a->remote, i = 0; bp != NULL; bp = (char *) GET(bp)){
+		if (!GET_ALLOC(HDRP(bp)) || IS_MAPPED(bp) || arena_of(bp) != a
+		    || ++i > heap_bytes / MIN_BLOCK_SIZE){
+			printf("Block %p on the remote free stack is free, mapped, of another arena or in a cycle\n", bp);
+			return 1;
+		}
+	}
+	return 0;
+}
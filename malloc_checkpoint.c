@@ -23,12 +23,26 @@
  * The heap begins with a padding of 4 bytes, followed by prologue header and footer
  * of 4 byte each, size 8 and a/f bit set, followed by user blocks, at the end is an epilogue block
  * of 4 bytes, size zero and a/f bit set.
+ *
+ * Built with -DFREE_TREE the free blocks are indexed by a splay tree
+ * keyed on size and address instead of the list, and find_fit is best
+ * fit in O(log n) amortized instead of a first fit scan. The left and
+ * right children take the place of the next and previous pointers, and
+ * the root that of the head of the list, so the block layout and the
+ * minimum block size stay the same.
+ *
+ * heap_stats counts the free bytes and blocks of each size class as blocks
+ * go in and out of the free list or tree, and the splits, coalesces and
+ * extensions of the heap, for mm_stats.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <limits.h>
 #include "mm.h"
 #include "memlib.h"
 
@@ -63,75 +77,66 @@
 #define free mm_free
 #define realloc mm_realloc
 #define calloc mm_calloc
+#define memalign mm_memalign
+#define posix_memalign mm_posix_memalign
+#define aligned_alloc mm_aligned_alloc
+#define malloc_usable_size mm_malloc_usable_size
 #endif /* def DRIVER */
 
-/* Basic constants and macros */
-#define WSIZE       4       /* word size (bytes) */  
-#define DSIZE       8      /* doubleword size (bytes) */
+/* Basic constants, the blocks themselves are those of mm_block.h */
 #define CHUNKSIZE  (1<<9)  /*initial heap size (bytes) */
 #define OVERHEAD    8       /* overhead of header and footer (bytes) */
-#define HEADER      4      /*Header size in bytes*/
-#define FOOTER      4      /*Footer size in bytes*/
-
-/* Pack a size and allocated bit into a word */
-#define PACK(size, alloc)  ((unsigned)((size) | (alloc)))
-
-/* Read and write a word at address p */
-#define GET(p)       (*(unsigned int *)(p))
-#define PUT(p, val)  (*(unsigned int *)(p) = (val))
-#define GET_8_byte(p)      (*(unsigned long *)(p)) /*As pointers in 64 bit system are 8 byte each use unsigned long*/
-#define PUT_8_byte(p, val) (*(unsigned long *)(p) = (unsigned long)(val)) 
-
-/* Read the size and allocated fields from address p */
-#define GET_SIZE(p)  (GET(p) & ~0x7) /*the 29 MSB bits determine the size as per the design*/
-#define GET_ALLOC(p) (GET(p) & 0x1) /*last bit is for allocated/free*/
-#define PREVIOUS_ALLOC(p) (GET(p) & 0x2) /*second last bit from LSB keeps track of whether the previous block is allocated*/
 
-/* Given block ptr bp, compute address of its header and footer */
-#define HDRP(bp)       ((char *)(bp) - WSIZE)  /*Address of header*/
-#define FTRP(bp)       ((char *)(bp) + GET_SIZE(HDRP(bp)) - DSIZE)
-
-/*Find the maximum of two numbers */
-#define MAX(x, y) ((x) > (y)? (x) : (y))
-
-/* Given block pointer bp, get the next and previous blocks */
-#define NEXT_BLOCK(bp)  ((char*)(bp) + GET_SIZE((char*)(bp) - WSIZE))
-#define PREV_BLOCK(bp)  ((char*)(bp) - GET_SIZE((char*)(bp) - DSIZE))
-
-/*For free block pointer bp, find the next free block pointed to by next field*/
-#define FREE_NEXT(bp) ((char*)(bp))
-/*for free block pointer bp, find previous fre block pointed to by previous field*/
-#define FREE_PREV(bp) ((char*)(bp) + DSIZE)
-
-/*For free block pointer bp, find the pointers to  next and previous free blocks */
-#define FREE_NEXT_PTR(bp)  ((char*)GET_8_byte((char*)(bp)))
-#define FREE_PREV_PTR(bp)  ((char*)GET_8_byte((char*)(bp) + DSIZE))
+/*Every block has a header and a footer*/
+#define BLOCK_LAYOUT LAYOUT_TAGS
+#include "mm_block.h"
 
 /*We keep two pointers to start and end of free lists*/
 /* Get the start and end of a list of free blocks*/
 #define HEAD_FREE ((char *)heap_head)
 #define TAIL_FREE ((char *)HEAD_FREE + DSIZE)
 /*Get the pointer to start and end of free list*/
-#define HEAD_FREE_PTR ((void *)GET_8_byte(HEAD_FREE))
-#define TAIL_FREE_PTR ((void *)GET_8_byte(TAIL_FREE))
+#define HEAD_FREE_PTR GET_LINK(HEAD_FREE)
+#define TAIL_FREE_PTR GET_LINK(TAIL_FREE)
 
 /*Global variables*/
 static char *heap_ptr;         /* Pointer to the heap*/
 static char *heap_head;       /* Head of the heap and head of free list */
-void *epilogue_ptr;                /* Point to the epilogue block as it keeps shifting */
+static struct mm_heap_stats heap_stats; /* Counters reported by mm_stats */
 
 /* Function prototypes for internal helper functions */
+#ifdef FREE_TREE
 static void add_free_blk(void* bp);
 static void rem_free_blk(void* bp);
-void *find_fit(size_t);
-void *extend_heap(size_t);
-void *coalesce(void *);
-void place(void*, size_t);
+#endif
+static void *find_fit(size_t);
 static void check_block(void *bp);
 static void print_block(void *bp);
 void print_list(void);
+static int check_stats(void);
+#ifdef FREE_TREE
+static int check_tree(void);
+#endif
 //static void _checkheap(void);
 
+/*
+ * The functions on blocks of mm_block.h, block_place, block_coalesce and
+ * block_extend, on the free tree, or else on the one list from HEAD_FREE
+ * to TAIL_FREE, where a freed block goes last (FIFO)
+ */
+#ifdef FREE_TREE
+#define BLOCK_ADD(bp, size) add_free_blk(bp)
+#define BLOCK_REM(bp, size) rem_free_blk(bp)
+#else
+#define LIST_HEAD(i)        ((char **) HEAD_FREE)[i] /*a single list, i is 0*/
+#define LIST_TAIL(i)        ((char **) TAIL_FREE)[i]
+#define LIST_INDEX(size)    0
+#define LIST_MARK(i)
+#define LIST_UNMARK(i)
+#endif
+#define BLOCK_STATS         heap_stats
+#include "mm_block.h"
+
 static int verbose;
 
 /* 
@@ -140,28 +145,28 @@ static int verbose;
  */
 int mm_init(void){
 	dbg1("Inside the function mm_init()\n");
+	memset(&heap_stats, 0, sizeof(heap_stats));
 
 	/* Create the initial empty heap starting with two pointers to free lists and padding block, prologue 
 	 * header and footer and then the epilogue block
 	 */
-	if((heap_ptr = mem_sbrk(2*DSIZE + 4*WSIZE)) == NULL){/*If sbrk funcion has an error, return -1*/
+	if((heap_ptr = mem_sbrk(2*DSIZE + 4*WSIZE)) == (void *) -1){/*If sbrk funcion has an error, return -1*/
 		return -1;
 	}
 	heap_head = heap_ptr;                          /*Keep the head of the heap to assign it to free list head later*/
-	PUT_8_byte(heap_ptr, NULL);                    /*Pointer to head of the free list*/
-	PUT_8_byte(heap_ptr + DSIZE, NULL);	       /*Pointer to end of free list*/
+	PUT_LINK(heap_ptr, NULL);                      /*Pointer to head of the free list*/
+	PUT_LINK(heap_ptr + DSIZE, NULL);	       /*Pointer to end of free list*/
 	heap_ptr = heap_ptr + 2*DSIZE; 	               /*start the heap after the two pointers*/
-	PUT(heap_ptr, 0);                              /*Padding for alignment to 8 bytes*/
-	PUT(heap_ptr + WSIZE, PACK(OVERHEAD, 1));      /*Prologue header of 4 bytes that has the size and a/f bit as 1 */
-	PUT(heap_ptr + (2 * WSIZE), PACK(OVERHEAD, 1));/*Prologue footer follows and is identical to header */ 
-	PUT(heap_ptr + (3 * WSIZE), PACK(0, 1));       /*At the end is the Epilogue header with 0 size and a/f set to 1 */
-	epilogue_ptr = (unsigned *)(heap_ptr+3*WSIZE); /*Save the pointer to epilogue block as this will keep shifting as we extend the heap*/
+	PUT_4(heap_ptr, 0);                            /*Padding for alignment to 8 bytes*/
+	PUT_4(heap_ptr + WSIZE, PACK(OVERHEAD, 1));    /*Prologue header of 4 bytes that has the size and a/f bit as 1 */
+	PUT_4(heap_ptr + (2 * WSIZE), PACK(OVERHEAD, 1));/*Prologue footer follows and is identical to header */ 
+	PUT_4(heap_ptr + (3 * WSIZE), PACK(0, 1));     /*At the end is the Epilogue header with 0 size and a/f set to 1 */
 
 	/* Move the heap pointer next to prologue header*/
 	heap_ptr += DSIZE;
 
 	/* Extend the empty heap with a free block of CHUNKSIZE bytes */
-	if(extend_heap(CHUNKSIZE/WSIZE) == NULL){ /*If extend_heap throws an error, return -1*/
+	if(block_extend(CHUNKSIZE) == NULL){ /*If extending the heap fails, return -1*/
 		return -1;
 	}
 
@@ -199,16 +204,16 @@ void *malloc(size_t size){
   
 	/* Search the free list for a fit and place it if found*/
 	if((bp = find_fit(asize)) != NULL){ /*If a fit is found, place it*/
-		place(bp, asize);
+		block_place(bp, asize);
 		dbg1("found a fitin free list in malloc()\n");
 		return bp;
 	} 
 	/* No fit found. Get more memory and place the block. */
 	extendsize = MAX(asize, CHUNKSIZE);
-	if ((bp = extend_heap(extendsize / WSIZE)) == NULL){ /*If no heap space available*/
+	if ((bp = block_extend(extendsize)) == NULL){ /*If no heap space available*/
 		return NULL;
 	}
-	place(bp, asize);/*place the block*/
+	block_place(bp, asize);/*place the block*/
 	dbg1("Exiting malloc by extending the heap\n");
   
 	return bp;
@@ -223,10 +228,16 @@ void *calloc(size_t nmemb, size_t size){
 	dbg1("Inside the function calloc()\n");
 	/*local variables*/
 	char *ptr;
-	int total_size;
+	size_t total_size;
 
+	if (size != 0 && nmemb > ~(size_t) 0 / size){
+		return NULL; /*nmemb * size overflows*/
+	}
  	total_size = (nmemb * size); /*Total size needed to be allocated*/
 	ptr = (char *) malloc(total_size); /*Call malloc() to allocate space and get the pointer to first byte*/
+	if (ptr == NULL){
+		return NULL;
+	}
 	
 	/* After the allcattion, initialize each byte to zero, similar to abzero function */
 	memset(ptr, 0 , total_size);
@@ -235,6 +246,114 @@ void *calloc(size_t nmemb, size_t size){
 	return ptr;
 }
 
+/*
+ * memalign - Allocate a block of size bytes aligned to alignment
+ * bytes (a power of two). We malloc enough to find an aligned payload
+ * with room for a minimum block in front of it, and split that slack
+ * off as a free block.
+ */
+void *memalign(size_t alignment, size_t size){
+	char *bp;     /*block as allocated*/
+	char *abp;    /*aligned block inside it*/
+	size_t blk_size, lead;
+
+	if (size == 0 || (alignment & (alignment - 1)) != 0){ /*not a power of two*/
+		return NULL;
+	}
+	if (alignment <= DSIZE){
+		return malloc(size);
+	}
+	if (size > SIZE_MAX - alignment - OVERHEAD - 2*DSIZE){
+		return NULL; /*the padded size would wrap around*/
+	}
+	if ((bp = malloc(size + alignment + OVERHEAD + 2*DSIZE)) == NULL){
+		return NULL;
+	}
+	abp = (char *) (((size_t) bp + alignment - 1) & ~(alignment - 1));
+	if (abp != bp && (size_t) (abp - bp) < OVERHEAD + 2*DSIZE){ /*slack too small to be a free block*/
+		abp += alignment;
+	}
+	if (abp != bp){
+		lead = abp - bp;
+		blk_size = GET_SIZE(HDRP(bp));
+		PUT_4(HDRP(abp), PACK(blk_size - lead, 1)); /*the aligned block*/
+		PUT_4(FTRP(abp), PACK(blk_size - lead, 1));
+		PUT_4(HDRP(bp), PACK(lead, 1)); /*the slack, freed below*/
+		PUT_4(FTRP(bp), PACK(lead, 1));
+		heap_stats.splits++;
+		free(bp);
+	}
+	return abp;
+}
+
+/*
+ * posix_memalign - memalign with the block returned in *memptr and
+ * an error number instead of NULL
+ */
+int posix_memalign(void **memptr, size_t alignment, size_t size){
+	void *bp;
+
+	if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0){
+		return EINVAL;
+	}
+	if (size == 0){
+		*memptr = NULL;
+		return 0;
+	}
+	if ((bp = memalign(alignment, size)) == NULL){
+		return ENOMEM;
+	}
+	*memptr = bp;
+	return 0;
+}
+
+/*
+ * aligned_alloc - The C11 name of memalign
+ */
+void *aligned_alloc(size_t alignment, size_t size){
+	return memalign(alignment, size);
+}
+
+/*
+ * malloc_usable_size - Payload bytes of the block ptr, between
+ * its header and footer
+ */
+size_t malloc_usable_size(void *ptr){
+	if (ptr == NULL){
+		return 0;
+	}
+	return GET_SIZE(HDRP(ptr)) - OVERHEAD;
+}
+
+/*
+ * mm_stats - Copy the counters of the heap into st, with the free
+ * totals summed over the size classes. Nothing is ever mapped.
+ */
+void mm_stats(struct mm_heap_stats *st){
+	size_t i;
+
+	*st = heap_stats;
+	st->heap_size = mem_heapsize();
+	for (i = 0; i < MM_SIZE_CLASSES; i++){
+		st->free_bytes += st->class_bytes[i];
+		st->free_blocks += st->class_blocks[i];
+	}
+	/*the list pointers, padding, prologue and epilogue are in no block*/
+	st->alloc_bytes = st->heap_size - (2*DSIZE + 4*WSIZE) - st->free_bytes;
+}
+
+/*
+ * mm_heap_walk - Call visit on every block of the heap after the
+ * prologue in address order, with its size and whether it is allocated
+ */
+void mm_heap_walk(void (*visit)(void *arg, void *bp, size_t size, int alloc), void *arg){
+	char *bp;
+
+	for (bp = NEXT_BLKP(heap_ptr); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp)){
+		visit(arg, bp, GET_SIZE(HDRP(bp)), GET_ALLOC(HDRP(bp)) != 0);
+	}
+}
+
 /*
  * free - Free a given block and coalesce it
  * with an adjacent free block if any
@@ -250,10 +369,9 @@ void free(void *ptr){
 	size = GET_SIZE(HDRP(ptr));
 
 	/* Set the a/f bit of header and footer to zero */
-	PUT(HDRP(ptr), PACK(size, 0));
-	PUT(FTRP(ptr), PACK(size, 0));
+	block_set_free(ptr, size);
 	/*Now coalesce this free block with any adjacent free block*/
-	coalesce(ptr);
+	block_coalesce(ptr);
 
 	dbg1("Succesfully exiting free()\n");  
 }
@@ -299,190 +417,183 @@ void *realloc(void *oldptr, size_t size){
 
 /* The remaining routines are internal helper routines */
 
+#ifdef FREE_TREE
 /*
- * Insert a freshly freed block into the list of free
- * blocks, as of now we have implemented FIFO and insert
- * the new block at the end of all free blocks in the list
+ * The free tree. Free blocks are kept in a splay tree ordered by size
+ * and then by address, so no two blocks compare equal. The root sits
+ * in the head of free list slot and each free block keeps its left and
+ * right children where the list keeps its next and previous pointers.
+ * Every search splays the block it ends on to the root, so the blocks
+ * used most often stay near the top and each operation is O(log n)
+ * amortized.
  */
+#define TREE_ROOT          ((char *)HEAD_FREE_PTR)
+#define TREE_LEFT(bp)      GET_NEXT_FREE(bp)
+#define TREE_RIGHT(bp)     GET_PREV_FREE(bp)
+#define SET_LEFT(bp, p)    PUT_LINK(NEXT_FREE(bp), p)
+#define SET_RIGHT(bp, p)   PUT_LINK(PREV_FREE(bp), p)
 
-static void add_free_blk(void* bp){
-	dbg1("Inside  add_free_blk()\n");
-
-	/* if the list is empty,set the head_free to point to this block*/
-	if(HEAD_FREE_PTR == NULL){
-		PUT_8_byte(HEAD_FREE, bp);
-		PUT_8_byte(FREE_PREV(bp), NULL); /*Set its prev pointer as null*/
-	}
-	else{
-		/* if there are free blocks, add this one at the end*/
-		PUT_8_byte(FREE_PREV(bp), TAIL_FREE_PTR); /*prev ptr of this is the old tail ptr*/
-		PUT_8_byte(FREE_NEXT(TAIL_FREE_PTR), bp); /*set next ptr of old tail ptr to this one*/
-	}
+/*
+ * tree_cmp - Compare the key (size, addr) with the block bp, returns
+ * less than, equal to or greater than zero like strcmp
+ */
+static int tree_cmp(size_t size, char *addr, char *bp){
+	size_t bsize = GET_SIZE(HDRP(bp));
 
-	/*Set the next ptr of this block to NULL so this is the last block in the list */
-	PUT_8_byte(FREE_NEXT(bp), NULL);
-	PUT_8_byte(TAIL_FREE, bp);/*New tail ptr is this block*/
+	if (size != bsize)
+		return size < bsize ? -1 : 1;
+	if (addr != bp)
+		return addr < bp ? -1 : 1;
+	return 0;
+}
 
-	dbg1("Exiting the add_free_blk() function successfully\n");
+/*
+ * splay - Top down splay of the tree rooted at t on the key (size, addr).
+ * Returns the new root, which is the block with that key if there is
+ * one and otherwise the last block on the search path, the next larger
+ * or the next smaller block.
+ */
+static char *splay(char *t, size_t size, char *addr){
+	char *left_root = NULL, *left_max = NULL;   /*blocks smaller than the key*/
+	char *right_root = NULL, *right_min = NULL; /*blocks larger than the key*/
+	char *y;
+	int c;
 
-        return;
+	if (t == NULL)
+		return NULL;
+	while ((c = tree_cmp(size, addr, t)) != 0){
+		if (c < 0){
+			if ((y = TREE_LEFT(t)) == NULL)
+				break;
+			if (tree_cmp(size, addr, y) < 0){ /*rotate right*/
+				SET_LEFT(t, TREE_RIGHT(y));
+				SET_RIGHT(y, t);
+				t = y;
+				if (TREE_LEFT(t) == NULL)
+					break;
+			}
+			/*t and its right subtree go to the right tree*/
+			if (right_min == NULL)
+				right_root = t;
+			else
+				SET_LEFT(right_min, t);
+			right_min = t;
+			t = TREE_LEFT(t);
+		}
+		else{
+			if ((y = TREE_RIGHT(t)) == NULL)
+				break;
+			if (tree_cmp(size, addr, y) > 0){ /*rotate left*/
+				SET_RIGHT(t, TREE_LEFT(y));
+				SET_LEFT(y, t);
+				t = y;
+				if (TREE_RIGHT(t) == NULL)
+					break;
+			}
+			/*t and its left subtree go to the left tree*/
+			if (left_max == NULL)
+				left_root = t;
+			else
+				SET_RIGHT(left_max, t);
+			left_max = t;
+			t = TREE_RIGHT(t);
+		}
+	}
+	/*hang the left and right trees under t*/
+	if (left_max == NULL)
+		left_root = TREE_LEFT(t);
+	else
+		SET_RIGHT(left_max, TREE_LEFT(t));
+	if (right_min == NULL)
+		right_root = TREE_RIGHT(t);
+	else
+		SET_LEFT(right_min, TREE_RIGHT(t));
+	SET_LEFT(t, left_root);
+	SET_RIGHT(t, right_root);
+	return t;
 }
 
 /*
- * rem_free_blk- Remove the free block that
- * bp points to and update the prev and next ptrs
- * of neighboring blocks in the list. There can be four cases
- * the block can either be the first, last or middle block or
- * the only block in the list
+ * add_free_blk - Insert a free block into the tree, it becomes the root
  */
-static void rem_free_blk(void *bp){
-
-	dbg1("Inside function rem_free_blk()\n");
+static void add_free_blk(void *bp){
+	size_t size = GET_SIZE(HDRP(bp));
+	char *root = splay(TREE_ROOT, size, bp);
 
-	/*If bp points to the only block, mak ethe list empty*/
-	if((((void*)FREE_PREV_PTR(bp) == NULL)) && ((void*)FREE_NEXT_PTR(bp) == NULL)){
-		PUT_8_byte(HEAD_FREE, NULL); /*make the list null*/
-		PUT_8_byte(TAIL_FREE, NULL);
-		dbg1("Made the list empty, exiting rem_free_blk()\n");
-		return;
+	heap_stats.class_bytes[MM_SIZE_CLASS(size)] += size;
+	heap_stats.class_blocks[MM_SIZE_CLASS(size)]++;
+	if (root == NULL){
+		SET_LEFT(bp, NULL);
+		SET_RIGHT(bp, NULL);
 	}
-	else if((void*)FREE_PREV_PTR(bp) == NULL){ /*If first block in the list, remove this and update the list*/
-		PUT_8_byte(FREE_PREV(FREE_NEXT_PTR(bp)), NULL); /*set next block as the first block in the list*/
-		PUT_8_byte(HEAD_FREE, FREE_NEXT_PTR(bp)); /*head now points to this*/
+	else if (tree_cmp(size, bp, root) < 0){ /*root and its right subtree are larger*/
+		SET_LEFT(bp, TREE_LEFT(root));
+		SET_RIGHT(bp, root);
+		SET_LEFT(root, NULL);
 	}
-	else if((void*)FREE_NEXT_PTR(bp) == NULL){ /*If last block in the list, remove and update list*/
-		PUT_8_byte(FREE_NEXT(FREE_PREV_PTR(bp)), NULL); /*set the previous block as last block in list*/
-		PUT_8_byte(TAIL_FREE, FREE_PREV_PTR(bp)); /*tail now points to this block*/
+	else{
+		SET_RIGHT(bp, TREE_RIGHT(root));
+		SET_LEFT(bp, root);
+		SET_RIGHT(root, NULL);
 	}
-	else{ /*The block is in the middle, remove it and adjust prev and next blocks*/
-		PUT_8_byte(FREE_PREV(FREE_NEXT_PTR(bp)), FREE_PREV_PTR(bp));/*adjust prev ptr of next block to prev block*/
-		PUT_8_byte(FREE_NEXT(FREE_PREV_PTR(bp)), FREE_NEXT_PTR(bp)); /*adjust next ptr of prev block to next blk*/
- 	}
-        dbg1("Exiting rem_free_blk()\n");
+	PUT_LINK(HEAD_FREE, bp);
 }
 
 /*
- * find_fit - Find a fit for a block with asize bytes
- * from the list of free blocks we have maintained
- * we have implemented first fit as of now
+ * rem_free_blk - Remove a free block from the tree. The block is found
+ * by its size, so this must be called before its header changes; a
+ * block that is not in the tree is left alone.
  */
-void *find_fit(size_t asize){
-        dbg1("Inside find_fit()\n");
-        void* bp; /*Hold the pointer to current free block*/
-
-        /* First fit search */
-        /*iterate from head of free lists till ptr is null, to get a block that fits*/
-        for(bp = (void *)HEAD_FREE_PTR; bp != NULL; bp = (void *)FREE_NEXT_PTR(bp)){
-                if(asize <= GET_SIZE(HDRP(bp))){ /*if the requested block fits in this, return ptr to this block*/
-                        dbg1("Found a fit , returning from find_fit()\n");
-                        return bp;
-                }
-        }
-        /*otherwise, no fit found*/
-        dbg1("did not find a fit, returning from find_fit()\n");
-        return NULL;
-}
+static void rem_free_blk(void *bp){
+	size_t size = GET_SIZE(HDRP(bp));
+	char *root = splay(TREE_ROOT, size, bp);
 
-/* 
- * extend_heap - Extend heap with free blocks of words
- * and return a pointer to it
- */
-void *extend_heap(size_t words){
-	dbg1("Inside extend_heap()\n");
-	char *bp;     /* A pointer to extended heap*/
-	size_t size;  /* Requested size*/
-	/* Allocate an even number of words to maintain alignment */
-	size = (words % 2) ? (words+1) * WSIZE : words * WSIZE;
-	if((long)(bp = mem_sbrk(size)) < 0) {/*if sbrk error, return NULL*/
-		dbg1("Exiting extend_heap() sbrk error\n");
-		return NULL;
+	if (root != bp){
+		PUT_LINK(HEAD_FREE, root);
+		return;
 	}
-
-	/* Initialize the free block header, footer and new epilogue header*/
-	PUT(HDRP(bp), PACK(size, 0));
-	PUT(FTRP(bp), PACK(size, 0));
-	PUT(HDRP(NEXT_BLOCK(bp)), PACK(0, 1));
-
-	epilogue_ptr = (unsigned *)HDRP(NEXT_BLOCK(bp)); /*update the pointer to new epilogue block*/
-
-	dbg1("Succesfully exiting from extend_heap()\n");
- 	return coalesce(bp);/*coalesce if any adjacent free block*/
+	heap_stats.class_bytes[MM_SIZE_CLASS(size)] -= size;
+	heap_stats.class_blocks[MM_SIZE_CLASS(size)]--;
+	if (TREE_LEFT(root) == NULL){
+		root = TREE_RIGHT(root);
+	}
+	else{ /*the largest block on the left becomes the root, it has no right child*/
+		root = splay(TREE_LEFT(bp), size, bp);
+		SET_RIGHT(root, TREE_RIGHT(bp));
+	}
+	PUT_LINK(HEAD_FREE, root);
 }
 
-
 /*
- * coalesce - perform boundary tag coalescing.
- * Merge any two adjacent free blocks and 
- * return a pointer  to coalesced block
+ * find_fit - Best fit: the smallest free block of at least asize
+ * bytes, the lowest addressed one among blocks of that size
  */
-void *coalesce(void *bp){
-	dbg1("Inside coalesce()\n");
-	size_t size = GET_SIZE(HDRP(bp));
-	size_t next_blk_a = GET_ALLOC(HDRP(NEXT_BLOCK(bp))); /*check if next block is allocated*/
-	size_t prev_blk_a = (GET_ALLOC((unsigned char *)HDRP(bp) - FOOTER) << 2); /*check if prev block is allocated and shift by 2*/
-	int check;
-
-	check = (prev_blk_a | next_blk_a);
-
-	switch(check){
-	 case 0:
-                 /*if both next and previous are free*/
-                size += GET_SIZE(HDRP(PREV_BLOCK(bp))) + GET_SIZE(FTRP(NEXT_BLOCK(bp)));/*size is size plus size of prev and next blocks*/
-		rem_free_blk(NEXT_BLOCK(bp));/*update free list and remove prev and next blocks from it*/
-                rem_free_blk(PREV_BLOCK(bp));
-                PUT(HDRP(PREV_BLOCK(bp)), PACK(size, 0));/*coalesce with prev and next blocks*/
-                PUT(FTRP(NEXT_BLOCK(bp)), PACK(size, 0));
-                add_free_blk(PREV_BLOCK(bp)); /*Now add this big new block to free list*/
-                bp = PREV_BLOCK(bp); /*update pointer*/
-                break;
-	case 1: /*If previous block is free but next block is not*/
-		size += GET_SIZE(HDRP(PREV_BLOCK(bp)));/*size is size plus previous block's size*/
-		rem_free_blk(PREV_BLOCK(bp));
-		PUT(HDRP(PREV_BLOCK(bp)), PACK(size, 0));/*coalesce with prev block*/
-		PUT(FTRP(bp), PACK(size, 0));
-		rem_free_blk(PREV_BLOCK(bp));/*remove previosu block from free list*/
-		add_free_blk(PREV_BLOCK(bp)); /*add this new block to free list*/
-		bp = PREV_BLOCK(bp); /*update pointer*/
-                break;
-	case 4: /*If next block is free but previous block is not*/
-		size += GET_SIZE(HDRP(NEXT_BLOCK(bp)));/*size is size plus next block's size*/
-		rem_free_blk(NEXT_BLOCK(bp));
-		PUT(HDRP(bp), PACK(size, 0));/*coalesce with next block*/
-		PUT(FTRP(bp), PACK(size, 0));		
-		add_free_blk(bp);
-		break;
-	case 5: /*If both prev and next are allocated*/
-		add_free_blk(bp);
-	}
-	return (bp);
+static void *find_fit(size_t asize){
+	char *root = splay(TREE_ROOT, asize, NULL);
+	char *bp;
+
+	PUT_LINK(HEAD_FREE, root);
+	if (root == NULL || GET_SIZE(HDRP(root)) >= asize)
+		return root;
+	/*the root is the next smaller block, the fit is the least block right of it*/
+	if ((bp = TREE_RIGHT(root)) != NULL){
+		while (TREE_LEFT(bp) != NULL)
+			bp = TREE_LEFT(bp);
+	}
+	return bp;
 }
 
+#else /* !FREE_TREE */
+
 /*
- * place - Place block of asize bytes at the block
- * pointed to by bp and split if the remainder >= minimum
- * block size
+ * find_fit - Find a fit for a block with asize bytes
+ * from the list of free blocks we have maintained
+ * we have implemented first fit as of now
  */
-void place(void *bp, size_t asize){
-        dbg1("Inside place()\n");
-        size_t blk_size = GET_SIZE(HDRP(bp));
-
-        /*Remmove this block from free list and check for splitting */
-        rem_free_blk(bp);
-        if (blk_size - asize < OVERHEAD + 2*DSIZE){ /*if remainder is < minimum block size, allocate the whole block*/
-                PUT(HDRP(bp), PACK(blk_size, 1));/*allocate the whole block, set header and footer*/
-                PUT(FTRP(bp), PACK(blk_size, 1));
-        }
-        else{ /*otherwise remiander >= min block size*/
-                asize = (asize + 0x7) & ~0x7; /*align the size*/
-                PUT(HDRP(bp), PACK(asize, 1)); /*allocate a block of this size, set header and footer*/
-                PUT(FTRP(bp), PACK(asize, 1));
-                PUT(HDRP(NEXT_BLOCK(bp)), PACK(blk_size - asize, 0)); /*split the block and set the remainder free*/
-                PUT(FTRP(NEXT_BLOCK(bp)), PACK(blk_size - asize, 0));
-                add_free_blk((void*)NEXT_BLOCK(bp)); /*add the split block to the pool of free blocks*/
-        }
-
-        dbg1("Exiting the function place()\n");
+static void *find_fit(size_t asize){
+	return block_find_in_list(0, asize);
 }
+#endif /* FREE_TREE */
 
 /*
  *  * mm_checkheap - Performs various sanity checks on heap
@@ -495,10 +606,10 @@ static void print_block(void *bp){
 
   hsize = GET_SIZE(HDRP(bp));
   halloc = GET_ALLOC(HDRP(bp));
-	hpalloc = PREVIOUS_ALLOC(HDRP(bp));
+	hpalloc = GET_PREV_ALLOC(HDRP(bp));
   fsize = GET_SIZE(FTRP(bp));
   falloc = GET_ALLOC(FTRP(bp));
-	fpalloc = PREVIOUS_ALLOC(HDRP(bp));
+	fpalloc = GET_PREV_ALLOC(HDRP(bp));
 
   if (hsize == 0) {
     printf("%p: EOL (size=0): header: [%ld:%c:%c]\n", bp,
@@ -529,7 +640,7 @@ static void check_block(void *bp){
 
   /* allocated block does not have footer */
 	if (!halloc) {
-		if (GET(HDRP(bp)) != GET(FTRP(bp))) {
+		if (GET_4(HDRP(bp)) != GET_4(FTRP(bp))) {
 			printf("Error: header does not match footer\n");
 			exit(0);
 		}
@@ -545,7 +656,6 @@ static void check_block(void *bp){
 int mm_checkheap(int v){
 	verbose  = v;
 	char *bp = heap_ptr;
-	size_t prev_alloc;//,curr_alloc;
 
 	dbg1("\n[verbose:%d]\n", verbose);
 	dbg1("\n[CHECK HEAP]\n");
@@ -564,36 +674,128 @@ int mm_checkheap(int v){
 					return 1;
 		  								}
 							check_block(heap_ptr); // alignment, header/footer
-						prev_alloc = GET_ALLOC(HDRP(bp));
-		 
+#ifdef FREE_TREE
+	if (check_tree())
+		return 1;
+#endif
+	if (check_stats())
+		return 1;
+	dbg1("[CHECK DONE]\n\n");
+	return 0;
+}
+
 /*
-	 // checking allocated/free blocks
-	for (bp = NEXT_BLKP(heap_listp); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp)) {
-		curr_alloc = GET_PREV_ALLOC(HDRP(bp));
-		if (verbose)
-			printblock(bp);
-		if (!prev_alloc != !curr_alloc) {
-		// previous block's allocate bit should match current block's prev allocate bit
-		printf("prev allocate bit mismatch\n");
-		exit(0);
+ * check_stats - The per class free counts of heap_stats match the free
+ * blocks found walking the heap
+ */
+static int check_stats(void){
+	size_t bytes[MM_SIZE_CLASSES] = {0}, blocks[MM_SIZE_CLASSES] = {0};
+	size_t i;
+	char *bp;
+
+	for (bp = heap_ptr; GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp)){
+		if (!GET_ALLOC(HDRP(bp))){
+			bytes[MM_SIZE_CLASS(GET_SIZE(HDRP(bp)))] += GET_SIZE(HDRP(bp));
+			blocks[MM_SIZE_CLASS(GET_SIZE(HDRP(bp)))]++;
+		}
+	}
+	for (i = 0; i < MM_SIZE_CLASSES; i++){
+		if (bytes[i] != heap_stats.class_bytes[i] || blocks[i] != heap_stats.class_blocks[i]){
+			printf("Error: size class %lu has %lu free blocks of %lu bytes, the counters say %lu of %lu\n",
+				(unsigned long) i, (unsigned long) blocks[i], (unsigned long) bytes[i],
+				(unsigned long) heap_stats.class_blocks[i], (unsigned long) heap_stats.class_bytes[i]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+#ifdef FREE_TREE
+/*
+ * tree_walk - Visit the free tree in order without a stack (Morris
+ * traversal): the right pointer of each predecessor is borrowed as a
+ * thread back to its successor while its left subtree is walked, and
+ * put back afterwards. visit returns nonzero to report an error.
+ */
+static int tree_walk(int (*visit)(char *bp, char *prev)){
+	char *bp = TREE_ROOT, *prev = NULL, *pred;
+	int err = 0;
+
+	while (bp != NULL){
+		if (TREE_LEFT(bp) == NULL){
+			err |= visit(bp, prev);
+			prev = bp;
+			bp = TREE_RIGHT(bp);
+			continue;
+		}
+		for (pred = TREE_LEFT(bp); TREE_RIGHT(pred) != NULL && TREE_RIGHT(pred) != bp; )
+			pred = TREE_RIGHT(pred);
+		if (TREE_RIGHT(pred) == NULL){ /*first time here, thread and go left*/
+			SET_RIGHT(pred, bp);
+			bp = TREE_LEFT(bp);
+		}
+		else{ /*back from the left subtree, unthread*/
+			SET_RIGHT(pred, NULL);
+			err |= visit(bp, prev);
+			prev = bp;
+			bp = TREE_RIGHT(bp);
 		}
-		prev_alloc = GET_ALLOC(HDRP(bp));
-		checkblock(bp);
- 	}*
-// checking epilouge block
-	if ((GET_SIZE(HDRP(bp)) != 0) || !(GET_ALLOC(HDRP(bp)))){
-		printf("Bad epilogue header\n");
-		printf("-epilogue-");
-		printblock(bp);
+	}
+	return err;
+}
+
+static int tree_count;
+
+/*
+ * check_node - Each block in the tree is free and larger than the one before
+ */
+static int check_node(char *bp, char *prev){
+	tree_count++;
+	check_block(bp);
+	if (GET_ALLOC(HDRP(bp))){
+		printf("Error: allocated block %p in the free tree\n", bp);
 		return 1;
-	}*/
-	dbg1("[CHECK DONE]\n\n");
+	}
+	if (prev != NULL && tree_cmp(GET_SIZE(HDRP(prev)), prev, bp) >= 0){
+		printf("Error: free tree out of order at %p\n", bp);
+		return 1;
+	}
+	return 0;
+}
+
+static int print_node(char *bp, char *prev){
+	(void) prev;
+	print_block(bp);
 	return 0;
 }
 
+/*
+ * check_tree - The tree is in order and holds every free block in the heap
+ */
+static int check_tree(void){
+	int heap_count = 0, err;
+	char *bp;
+
+	for (bp = heap_ptr; GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp))
+		heap_count += !GET_ALLOC(HDRP(bp));
+	tree_count = 0;
+	err = tree_walk(check_node);
+	if (tree_count != heap_count){
+		printf("Error: %d free blocks in the heap but %d in the free tree\n",
+			heap_count, tree_count);
+		err = 1;
+	}
+	return err;
+}
+
+void print_list(void){
+	tree_walk(print_node);
+}
+#else
 void print_list(void){
 	void* bp = HEAD_FREE_PTR;
-	for (;bp != NULL;bp = FREE_NEXT_PTR(bp))
+	for (;bp != NULL;bp = GET_NEXT_FREE(bp))
 		print_block(bp);
 }
+#endif
 
@@ -9,19 +9,81 @@
  * the design of header and footer is as follows:
  * 31                          3  2  1  0
  * --------------------------------------
- * s  s  s  .....  . s  s  s s  s  0 pa  a/f 
+ * s  s  s  .....  . s  s  s s  s  m pa  a/f 
  * --------------------------------------
  * where s bits together indicate the size of the block, pa bit indicates if 
- * the previous block is allocated or not, and the a/f bit indicate whether the block is free or allocated
+ * the previous block is allocated or not, and the a/f bit indicate whether the block is free or allocated,
+ * the m bit is only set for a block with a mapping of its own (see below)
  * For each free block, we we have a header and footer of 4 byte each
  * and a pointer to the next and previous free blocks (8 byte each for 64 bit system)
  * For each allocated block, we have a header and payload.
  *
- * The heap starts with pointers to heads of each segregated lists, followed by a padding of 4 bytes,
- * then prologue block, allocated blocks and then the epilogue block
+ * The heap starts with pointers to heads of each segregated lists, followed by a bitmap
+ * of the non-empty lists, a padding of 4 bytes, then prologue block, allocated blocks
+ * and then the epilogue block. The list of a size is found with count leading zeros,
+ * and the next non-empty list with count trailing zeros on the bitmap.
  *
- * For the implementation here, the minimum block size os 24 bytes, each chunk is 168 bytes
+ * For the implementation here, the minimum block size os 24 bytes (16 compact), the first chunk is 168 bytes
  * and each of the segregated lists is a power of two, in increasing order, we have 12 total lists
+ *
+ * Built with -DMM_THREADS the allocator is thread safe: the heap is guarded by a lock
+ * and every thread keeps a cache of small blocks per size class in front of it.
+ *
+ * Built with -DMM_QUICK freed blocks of up to 512 bytes go on quick lists, one per
+ * size, without coalescing; they are coalesced in one batch when a list overflows
+ * or a larger request finds no fit.
+ *
+ * Built with -DMM_SLAB requests of up to 128 bytes are served from page sized slabs
+ * of equal slots without headers, found from a slot by masking its address.
+ *
+ * Built with -DMM_COMPACT the next and previous links of a free block are 4 byte
+ * offsets from the start of the heap instead of pointers, so the minimum block
+ * drops to 16 bytes; the heap must then stay below 4 GB.
+ *
+ * Built with -DTLSF, the 12 lists are replaced by a two level segregated fit index:
+ * a power of two first level split linearly into 16 second level lists, searched
+ * as a good fit in O(1) with one bitmap per level.
+ *
+ * Requests of MMAP_THRESHOLD bytes or more never touch the heap: each gets a mapping
+ * of its own, resized with mem_remap and unmapped on free. When a free leaves more
+ * than TRIM_THRESHOLD bytes free at the top of the heap, the heap is shrunk back
+ * to TOP_PAD free bytes and the pages go back to the kernel.
+ *
+ * memalign, posix_memalign and aligned_alloc cut an aligned block out of a larger
+ * free block and give the slack in front of it back as a free block of its own.
+ *
+ * malloc_batch carves many blocks of one size out of a single free block, back to
+ * back, and free_many frees a sorted batch, each run of neighbours as one block.
+ *
+ * heap_fresh marks how far up the heap blocks have ever been handed out. Memory
+ * above it came zero filled from mem_sbrk and has only held the boundary tags of
+ * the top free block since, so calloc zeroes just the part of a block below it.
+ *
+ * heap_stats keeps the free bytes and blocks of each size class, updated as blocks
+ * go on and off the lists, and counts splits, coalesces, extensions and trims, so
+ * mm_stats reports on the heap without walking it; mm_checkheap checks them.
+ *
+ * Built with -DMM_PROFILE a backtrace is recorded about every PROF_RATE bytes
+ * allocated, with Poisson sampling, in a side table keyed by block address that
+ * free drops from; mm_profile_dump writes the live samples as a pprof heap profile.
+ *
+ * Built with -DMM_HUGE the heap is grown to, and trimmed back to, huge page
+ * boundaries (MEM_HUGE_PAGE, the heap starts on one) and each new huge page
+ * is advised to be backed by a transparent huge page, so the whole heap is
+ * mapped by a few TLB entries. Blocks larger than HOT_MAX are cut from the top
+ * of a free block, the small ones from its bottom, so the small blocks, most
+ * of those a program follows pointers through, stay packed together.
+ *
+ * Built with -DMM_RT (on top of -DTLSF) malloc and free take a bounded number of
+ * steps: mm_init makes the heap one pool of RT_POOL bytes and faults all of it in,
+ * find_fit is a good fit only and never walks a list, no block gets a mapping of
+ * its own and the heap is never grown nor trimmed, so after mm_init no call enters
+ * the kernel. A request fails instead when no list above its size has a block.
+ *
+ * mm_region_create makes a region for objects that all die together, such as the
+ * objects of one request: mm_region_alloc bumps a pointer through chunks that are
+ * ordinary blocks of the heap, grown in place while the heap lets them, and
+ * mm_region_destroy frees the chunks, usually one block, with one coalesce each.
  */
 #include <assert.h>
 #include <stdio.h>
@@ -29,6 +91,16 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#ifdef MM_THREADS
+#include <pthread.h>
+#endif
+#ifdef MM_PROFILE
+#include <fcntl.h>
+#include <execinfo.h>
+#include <sys/mman.h>
+#endif
 
 #include "mm.h"
 #include "memlib.h"
@@ -39,6 +111,12 @@
  *  - dbg_printf acts like printf, but will not be run in a release build.
  *  - checkheap acts like mm_checkheap, but prints the line it failed on and
  *  exits if it fails.
+
+ *  - checkheap_step does the same with mm_checkheap_step, a slice of the
+ *  heap at a time, every CHECK_EVERY calls; malloc and free call it in a
+ *  debug build, so a slice is walked in one go while it is in the cache.
+ *  - checkblock checks a block and its neighbours with check_local, in O(1);
+ *  free and coalesce call it in a debug build.
  */
 
 #ifndef NDEBUG
@@ -47,9 +125,21 @@
                              printf("Checkheap failed on line %d\n", __LINE__);\
                              exit(-1);  \
                         }}while(0)
+#define checkheap_step(verbose) do {static unsigned ticks;  \
+                        if (__atomic_add_fetch(&ticks, 1, __ATOMIC_RELAXED) % CHECK_EVERY == 0  \
+                            && mm_checkheap_step(verbose)) {  \
+                             printf("Checkheap step failed on line %d\n", __LINE__);\
+                             exit(-1);  \
+                        }}while(0)
+#define checkblock(bp) do {if (check_local(bp)) {  \
+                             printf("Check of block %p failed on line %d\n", (void *) (bp), __LINE__);\
+                             exit(-1);  \
+                        }}while(0)
 #else
 #define dbg_printf(...)
 #define checkheap(...)
+#define checkheap_step(...)
+#define checkblock(...)
 #endif
 
 /* do not change the following! */
@@ -59,103 +149,203 @@
 #define free mm_free
 #define realloc mm_realloc
 #define calloc mm_calloc
+#define memalign mm_memalign
+#define posix_memalign mm_posix_memalign
+#define aligned_alloc mm_aligned_alloc
+#define malloc_usable_size mm_malloc_usable_size
+#define free_sized mm_free_sized
+#define free_many mm_free_many
+#define malloc_batch mm_malloc_batch
 #endif				/* def DRIVER */
 
 
 
 /* define global constants */
-#define WSIZE       4
-#define DSIZE       8
-#define CHUNKSIZE   (168) /*extend heap by this amount in bytes*/
-#define OVERHEAD    8 /*header plus footer*/
-#define MIN_BLOCK_SIZE    24 /*minimum block size is header plus footer plus pointers to next and previous free blocks*/
-
-/* Function macros */
-#define MAX(x, y)   ((x) > (y) ? (x) : (y)) /*return the maximum of two entities*/
-#define MIN(x, y)   ((x) < (y) ? (x) : (y)) /*return minimum of two entities*/
-
-/* Pack a size and allocated bit into one single word */
-#define PACK(size, alloc)   ((size) | (alloc))
-
-/* Read and write from/to address p */
-#define GET(p)      (*((size_t*) (p))) /*Read 8 bytes from address p*/
-#define PUT(p, val) (*((size_t*) (p)) = (val)) /*place val at the address p*/
-
-/* Read and write from/to address p */
-#define GET_4(p)     (*((unsigned*) (p))) /*Read 4 bytes from p address*/
-#define PUT_4(p, val)(*((unsigned*) (p)) = (val)) /*Write val to address p*/
-
-/* For a block ptr bp, get address of next and previous blocks */
-#define NEXT_BLKP(bp)   ((char*)(bp) + GET_SIZE((char*)(bp) - WSIZE))
-#define PREV_BLKP(bp)   ((char*)(bp) - GET_SIZE((char*)(bp) - DSIZE))
-
-/* For a block pointer bp, get address of its header and footer */
-#define HDRP(bp)    ((char*)(bp) - WSIZE) /*As block pointer points to right after header*/
-#define FTRP(bp)    ((char*)(bp) + GET_SIZE(HDRP(bp)) - DSIZE)
-
-/* Read the size and allocated fields from address p */
-#define GET_SIZE(p)         (GET_4(p) & ~0x7) /*size is all 4 bytes in p except the 3 lsb bits*/
-#define GET_PREV_ALLOC(p)   (GET_4(p) & 0x2) /*prev allocated bit is 2nd lsb bit, indicating if previous block is allocated*/
-#define GET_ALLOC(p)        (GET_4(p) & 0x1) /*a/f bit is the lsb bit*/
-
-/* For a block ptr bp, which points to a free block 
- * get pointer to next and previous free blocks
- */
-#define NEXT_FREE(bp)   ((char*) ((char*)(bp)))
-#define PREV_FREE(bp)   ((char*) ((char*)(bp) + DSIZE))
-
-/* We use the lower 3 bits in the  header to store info about
- * whether or not the block is allocated and previous
- * block is allocated
- */
-#define ALLOC   0x01
-#define PREV_ALLOC  0x02
-
-/* Total number of segregated lists */
-#define NO_OF_LISTS   12
-
-/* Maximum size limit of each list in powers of two*/
-#define LIST0_SIZE      128
-#define LIST1_SIZE      256
-#define LIST2_SIZE      512
-#define LIST3_SIZE      1024
-#define LIST4_SIZE      2048
-#define LIST5_SIZE      4096
-#define LIST6_SIZE      8192
-#define LIST7_SIZE      16834
-#define LIST8_SIZE      32768
-#define LIST9_SIZE      65536
-#define LIST10_SIZE     131072
-
-/*
- * Offsets of segregated lists, as each of them
- * is a pointer to that list's header, each is 8 byte long
- */
-#define LIST_0     0
-#define LIST_1     8
-#define LIST_2     16
-#define LIST_3     24
-#define LIST_4     32
-#define LIST_5     40
-#define LIST_6     48
-#define LIST_7     56
-#define LIST_8     64
-#define LIST_9     72
-#define LIST_10    80
-#define LIST_11    88
+#define CHUNKSIZE   (168) /*extend heap by at least this amount in bytes*/
+#define GROW_MAX    (64 * 1024) /*largest chunk the heap is extended by, what a trim keeps*/
+#define GROW_FRACTION 16 /*and no more than this part of the heap*/
+
+/*
+ * Blocks, their tags and links are those of mm_block.h. With -DMM_COMPACT
+ * a link is the 4 byte offset of the block from heap_ptr, and 0, the list
+ * heads, is NULL. A compact heap also has seven more segregated lists in
+ * front: the 16 byte blocks and the splits they allow make for many
+ * more small sizes, which a first fit search of one list up to 128
+ * bytes would keep stepping over, so the blocks of 16 to 64 bytes get
+ * one list per size, where the head always fits.
+ */
+#ifdef MM_COMPACT
+#if MAX_HEAP > (1UL << 32)
+#error "MM_COMPACT links cannot reach past 4 GB of heap, lower MAX_HEAP"
+#endif
+#define LINK_SIZE           WSIZE
+#define GET_LINK(p)         (GET_4(p) ? heap_ptr + GET_4(p) : NULL)
+#define PUT_LINK(p, bp)     PUT_4(p, (bp) ? (unsigned) ((char *) (bp) - heap_ptr) : 0)
+#define EXACT_LISTS         7 /*lists of blocks of a single size*/
+#endif
+#include "mm_block.h"
+
+/*
+ * Large blocks and trimming. A mapped block is laid out as mm_block.h has
+ * it: the length of its mapping and the offset of the payload in it are
+ * in front of the usual header, which is marked MMAPPED | ALLOC.
+ */
+#ifndef MM_RT
+#define MMAP_THRESHOLD  (128 * 1024) /*requests this big get a mapping of their own*/
+#else
+#ifndef RT_POOL
+#define RT_POOL         (128UL << 20) /*bytes of the heap, all made by mm_init*/
+#endif
+#define MMAP_THRESHOLD  RT_POOL /*no mappings, and no request this big fits the pool*/
+#endif
+#ifndef MM_HUGE
+#define TRIM_THRESHOLD  (128 * 1024) /*most free bytes left at the top of the heap*/
+#else
+#define TRIM_THRESHOLD  (MEM_HUGE_PAGE + TOP_PAD) /*enough for a trim to give back a huge page*/
+#define HOT_MAX         512 /*larger blocks are cut from the top of a free block*/
+#endif
+#define TOP_PAD         (64 * 1024) /*free bytes kept at the top by a trim*/
+#define CHECK_SLICE     16 /*blocks mm_checkheap_step checks per call*/
+#define CHECK_EVERY     16 /*calls of malloc or free per checkheap_step in a debug build*/
+#define BATCH_MAX       (1UL << 30) /*most bytes malloc_batch carves out of one free block, or a region chunk holds*/
+#define REGION_CHUNK    (4 * 1024) /*bytes a region starts with if not told*/
+#define REGION_CHUNK_MAX (1024 * 1024) /*most bytes a region grows by at once*/
+#define RADIX_KEY(p, lo, shift) ((size_t) ((p) - (lo)) >> (shift) & 0xff) /*sort_ptrs bucket*/
+
+#ifndef TLSF
+/*
+ * The segregated lists of mm_block.h, SEG_LISTS powers of two from 128
+ * bytes up after the EXACT_LISTS of a compact heap
+ */
+#define NO_OF_LISTS   SEG_LISTS
+
+/*
+ * Right after the list heads the heap keeps a bitmap with bit i set
+ * iff list i is not empty, so a search never looks at empty lists
+ */
+#define SEG_BITMAP      (heap_ptr + NO_OF_LISTS * DSIZE)
+#define SEG_HDR_SIZE    ((NO_OF_LISTS + 1) * DSIZE) /*list heads plus bitmap*/
+
+#else
+/*
+ * With -DTLSF the lists form a two level index (two level segregated fit):
+ * the first level splits sizes by powers of two, and each power of two
+ * is split linearly into SL_COUNT second level lists. Below SMALL_LIMIT
+ * first level 0 has one list per 8 byte size. List i is (fl, sl) with
+ * i = fl * SL_COUNT + sl.
+ */
+#define SL_SHIFT        4 /*log2 of the number of second level lists*/
+#define SL_COUNT        (1 << SL_SHIFT)
+#define FL_SHIFT        (SL_SHIFT + 3) /*sizes below 2^FL_SHIFT all go in first level 0*/
+#define SMALL_LIMIT     (1 << FL_SHIFT)
+#define FL_COUNT        (32 - FL_SHIFT + 1) /*enough for any size a 4 byte header can hold*/
+#define NO_OF_LISTS     (FL_COUNT * SL_COUNT)
+
+/*
+ * After the list heads the heap keeps a bitmap of the first levels
+ * that have a non-empty list, then one bitmap of non-empty second
+ * level lists (4 bytes) per first level
+ */
+#define FL_BITMAP       (heap_ptr + NO_OF_LISTS * DSIZE)
+#define SL_BITMAP(fl)   (FL_BITMAP + DSIZE + (fl) * WSIZE)
+#define SEG_HDR_SIZE    (NO_OF_LISTS * DSIZE + DSIZE + FL_COUNT * WSIZE)
+#endif
+
+/*
+ * Offset of the head of list i from heap_ptr, each
+ * head is a pointer to the first block (8 bytes)
+ */
+#define LIST_OFFSET(i)  ((i) * DSIZE)
+
+#if defined(MM_RT) && (!defined(TLSF) || defined(MM_THREADS) || defined(MM_QUICK) || defined(MM_SLAB) || defined(MM_HUGE))
+#error "MM_RT needs the TLSF index and none of the front ends, which may walk lists, take locks or grow the heap"
+#endif
+
+#ifdef MM_SLAB
+#ifdef MM_THREADS
+#error "MM_SLAB and MM_THREADS cannot be combined, the thread caches already serve small blocks"
+#endif
+/*
+ * With -DMM_SLAB requests of up to SLAB_MAX_SIZE bytes are served from
+ * slabs: SLAB_SIZE aligned pages carved out of the heap and cut into equal
+ * slots without headers. A slab is a block of exactly SLAB_SIZE bytes, so
+ * the header of the next block takes the last word of the page and slabs
+ * allocated in a row fill consecutive pages. There is one class per 8
+ * bytes of slot size, and the heap keeps the head of the list of slabs
+ * with free slots of each class right after the segregated list heads.
+ */
+#define SLAB_SIZE       4096
+#define SLAB_USABLE     (SLAB_SIZE - WSIZE) /*bytes of the page in the slab block*/
+#define SLAB_MAX_SIZE   128
+#define SLAB_CLASSES    (SLAB_MAX_SIZE / DSIZE)
+#define SLAB_CLASS(size) (((size) + DSIZE - 1) / DSIZE - 1)
+#define SLAB_HEAD(c)    (heap_ptr + SEG_HDR_SIZE + (c) * DSIZE)
+#define HEAP_HDR_SIZE   (SEG_HDR_SIZE + SLAB_CLASSES * DSIZE)
+#define SLAB_MAP_WORDS  ((SLAB_SIZE / DSIZE + 63) / 64) /*enough bits for the smallest slots*/
+
+/*
+ * Header at the start of every slab, followed by the slots. A set
+ * bit i in free_map means slot i is free.
+ */
+typedef struct slab {
+	struct slab *next;              /*next slab of the class with free slots*/
+	struct slab *prev;              /*previous one*/
+	unsigned short cls;             /*size class*/
+	unsigned short slot_size;       /*bytes per slot*/
+	unsigned short nslots;          /*number of slots*/
+	unsigned short nfree;           /*number of free slots*/
+	size_t free_map[SLAB_MAP_WORDS];
+} slab_t;
+
+#define SLAB_SLOTS_OFFSET  ((sizeof(slab_t) + DSIZE - 1) & ~(DSIZE - 1))
+#define SLAB_OF(p)         ((slab_t *) ((size_t) (p) & ~(size_t) (SLAB_SIZE - 1)))
+#define SLAB_PAGE(p)       (((size_t) ((char *) (p) - (char *) mem_heap_lo())) / SLAB_SIZE)
+#else
+#define HEAP_HDR_SIZE   SEG_HDR_SIZE
+#endif
 
 /* Helper functions */
+static void *front_malloc(size_t size);
+static void *front_realloc(void *oldptr, size_t size);
+static void *heap_malloc(size_t size);
+static void heap_free(void *bp);
+static void free_in_heap(void *bp, size_t asize);
+static void free_blocks(char *bp, size_t size);
+static void sort_ptrs(char **p, size_t n);
+static void radix_sort(char **p, size_t n, char *lo, int shift);
+static void *heap_realloc(void *oldptr, size_t size);
+static void *large_malloc(size_t size);
+static void *large_memalign(size_t align, size_t size);
+static void large_free(void *bp);
+static void *large_realloc(void *oldptr, size_t size);
+#ifndef MM_RT
+static void trim_heap(char *bp);
+#endif
+#ifndef MM_THREADS
+static void zero_payload(char *bp, size_t size, char *fresh);
+#endif
+static size_t adjust_size(size_t size);
+static int heap_checkheap(int verbose);
+static int heap_check_step(int verbose);
+static int in_heap(const void *p);
+static void *alloc_block(size_t asize);
+static char *find_region(size_t asize);
+static size_t carve(char *bp, size_t asize, size_t n, void **out);
+static size_t grow_size(size_t need);
+static int grow_block(char *bp, size_t asize);
+static void *alloc_aligned(size_t align, size_t asize);
+static int region_grow(struct mm_region *r, size_t size);
+static char *align_payload(char *bp, size_t align);
 static void *extend_heap(size_t words);
-static void *coalesce(void *bp);
-static void *find_block_in_list(size_t index, size_t size);
 static void *find_fit(size_t asize);
 static void place(void *bp, size_t asize);
-static void add_free_blk(char *bp, size_t size);
-static void rem_free_blk(char *bp, size_t size);
+#ifdef MM_HUGE
+static char *place_high(char *bp, size_t asize);
+#endif
 static size_t get_index(size_t asize);
-static size_t find_list(size_t ind);
-static size_t find_list_by_size(size_t ind);
-static size_t get_list_size(size_t index);
+static void mark_list(size_t index);
+static void unmark_list(size_t index);
+static int list_marked(size_t index);
 static int  check_free_blk(char *blk);
 static int  check_alloc_blk(char *blk);
 static void  print_free_blk(char *blk);
@@ -163,10 +353,166 @@ static void  print_alloc_blk(char *blk);
 static int check_seg_lists();
 static int check_for_cycle();
 static int check_free_blk_count();
+static int check_stats(void);
+static int check_local(char *blk);
+static int check_list_heads(void);
 
 /* Global variables-- Base of the heap(heap_listp) */
 static char *heap_ptr;
-char *heap_start;
+static char *heap_start;
+static char *heap_fresh; /*no block has ever been allocated at or above this*/
+static size_t heap_grow; /*least number of bytes the next extension of the heap asks for*/
+static char *check_cursor; /*block mm_checkheap_step checks next, NULL for the first*/
+static struct mm_heap_stats heap_stats; /*counters of mm_stats, the mapped ones kept atomically*/
+
+/*the size bytes from bp became one block: mm_checkheap_step must not resume inside it*/
+#define CHECK_MERGED(bp, size) do { if (check_cursor > (char *) (bp) \
+				&& check_cursor < (char *) (bp) + (size)) check_cursor = (char *) (bp); } while (0)
+
+/*
+ * The functions on blocks of mm_block.h, block_place, block_coalesce and so
+ * on, working on the lists whose heads start the heap. They count in
+ * heap_stats, and a merge moves the check cursor off the blocks it removed.
+ */
+#define LIST_HEAD(i)        (*(char **) (heap_ptr + LIST_OFFSET(i)))
+#define LIST_INDEX(size)    get_index(size)
+#define LIST_MARK(i)        mark_list(i)
+#define LIST_UNMARK(i)      unmark_list(i)
+#ifndef TLSF
+#define LIST_BITMAP         GET(SEG_BITMAP)
+#endif
+#define BLOCK_STATS         heap_stats
+#define BLOCK_MAPPED        heap_stats
+#define BLOCK_MERGED(bp, size) do { CHECK_MERGED(bp, size); checkblock(bp); } while (0)
+#include "mm_block.h"
+
+#ifdef MM_SLAB
+/*
+ * One bit per SLAB_SIZE page of the heap, set iff the page is a slab,
+ * so free can tell slab slots from ordinary blocks by address alone
+ */
+static size_t slab_map[MAX_HEAP / SLAB_SIZE / 64];
+
+static void *slab_malloc(size_t size);
+static void slab_free(void *p);
+static void *slab_realloc(void *oldptr, size_t size);
+static slab_t *slab_new(size_t c);
+static int is_slab_ptr(const void *p);
+#endif
+
+#ifdef MM_QUICK
+#ifdef MM_THREADS
+#error "MM_QUICK and MM_THREADS cannot be combined, the thread caches already are quick lists"
+#endif
+/*
+ * Quick lists of freed small blocks, one list per 8 byte size
+ * class from MIN_BLOCK_SIZE to QL_MAX_SIZE (see the quick list front end)
+ */
+#define QL_MAX_SIZE      512 /*largest block size that is kept*/
+#define QL_CLASSES       ((QL_MAX_SIZE - MIN_BLOCK_SIZE) / DSIZE + 1)
+#define QL_CLASS(asize)  (((asize) - MIN_BLOCK_SIZE) / DSIZE)
+#define QL_LIMIT         64 /*most blocks a class may hold*/
+
+typedef struct {
+	char *head[QL_CLASSES];      /*last freed block of each class*/
+	unsigned count[QL_CLASSES];  /*number of blocks of each class*/
+	size_t blocks;               /*number of blocks of all classes*/
+} quick_t;
+
+static quick_t quick;
+
+static void *quick_malloc(size_t size);
+static void quick_free(void *bp);
+static void quick_flush(void);
+static int at_top(char *bp);
+static int check_quick_lists(void);
+#endif
+
+#ifdef MM_THREADS
+/*
+ * Per thread cache of small blocks, one list per 8 byte size class
+ * from MIN_BLOCK_SIZE to TC_MAX_SIZE (see the thread safe front end)
+ */
+#define TC_MAX_SIZE      512 /*largest block size that is cached*/
+#define TC_CLASSES       ((TC_MAX_SIZE - MIN_BLOCK_SIZE) / DSIZE + 1)
+#define TC_CLASS(asize)  (((asize) - MIN_BLOCK_SIZE) / DSIZE)
+#define TC_BATCH         16 /*blocks moved per refill or flush*/
+#define TC_LIMIT         (2 * TC_BATCH) /*most blocks a class may hold*/
+
+typedef struct {
+	char *head[TC_CLASSES];      /*first cached block of each class*/
+	unsigned count[TC_CLASSES];  /*number of cached blocks of each class*/
+	int registered;              /*exit handler installed for this thread*/
+} tcache_t;
+
+static __thread tcache_t tcache;
+static pthread_mutex_t heap_lock = PTHREAD_MUTEX_INITIALIZER; /*guards everything below the caches*/
+static pthread_key_t tcache_key; /*only used to flush caches at thread exit*/
+static pthread_once_t tcache_once = PTHREAD_ONCE_INIT;
+
+static void *tcache_malloc(size_t size);
+static void tcache_free(void *bp, size_t asize);
+static void tcache_refill(size_t c, size_t asize);
+static void tcache_flush(size_t c);
+static void tcache_register(void);
+static void tcache_make_key(void);
+static void tcache_destroy(void *arg);
+#endif
+
+#ifdef MM_PROFILE
+/*
+ * Sampling heap profiler (see the profiler section). The countdown to
+ * the next sample is per thread in the thread safe build, the table of
+ * live samples is shared and guarded by prof_lock.
+ */
+#define PROF_RATE        (512 * 1024) /*default mean bytes allocated between samples*/
+#define PROF_DEPTH       32 /*most frames kept of a backtrace*/
+#define PROF_SLOTS       (1 << 15) /*slots of the sample table, a power of two*/
+#define PROF_MAX         (PROF_SLOTS / 4 * 3) /*most live samples kept*/
+#define PROF_FILTER_SIZE (1 << 14) /*counters of the filter free looks at first*/
+#define PROF_HASH(p)     ((size_t) (((size_t) (p) >> 3) * 0x9E3779B97F4A7C15ULL >> 32))
+
+#ifdef MM_THREADS
+#define PROF_TLS __thread
+#else
+#define PROF_TLS
+#endif
+
+typedef struct {
+	char *addr;              /*block sampled, NULL for an empty slot*/
+	size_t size;             /*bytes asked for*/
+	int depth;               /*frames in stack*/
+	void *stack[PROF_DEPTH]; /*return addresses, innermost first*/
+} prof_entry;
+
+static prof_entry *prof_table;  /*PROF_SLOTS slots, open addressing, mapped on first use*/
+static size_t prof_count;       /*live samples in the table*/
+static size_t prof_rate = PROF_RATE;
+static unsigned char prof_filter[PROF_FILTER_SIZE]; /*samples per filter slot, none means not sampled*/
+static PROF_TLS long prof_countdown;      /*bytes to allocate before the next sample*/
+static PROF_TLS unsigned long long prof_rng; /*state of the sampling random numbers, 0 until seeded*/
+static PROF_TLS int prof_busy;            /*taking a sample, do not sample the mallocs it makes*/
+#ifdef MM_THREADS
+static pthread_mutex_t prof_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/*count size bytes allocated at bp against the countdown, and sample bp when it runs out*/
+#define PROF_ALLOC(bp, size) do { if ((prof_countdown -= (long) (size)) < 0) prof_sample(bp, size); } while (0)
+/*whether bp may have a sample; the filter spares most frees the table lookup*/
+#define PROF_MAYBE(bp) (__atomic_load_n(&prof_filter[PROF_HASH(bp) & (PROF_FILTER_SIZE - 1)], \
+				__ATOMIC_RELAXED) != 0)
+/*drop the sample of bp, if it has one*/
+#define PROF_FREE(bp) do { if (PROF_MAYBE(bp)) prof_forget(bp, NULL); } while (0)
+
+static void prof_sample(void *bp, size_t size);
+static void prof_insert(void *bp, size_t size, void **stack, int depth);
+static int prof_forget(void *bp, prof_entry *out);
+static long prof_next(void);
+static int check_profile(void);
+#else
+#define PROF_ALLOC(bp, size) do {} while (0)
+#define PROF_FREE(bp)        do {} while (0)
+#endif
 
 
 /* 
@@ -177,27 +523,28 @@ char *heap_start;
  */
 int mm_init(void){
 
-	/* we start with allocating pointers (8 bytes) to each segregated list */
-	if ((heap_ptr = mem_sbrk(NO_OF_LISTS * DSIZE)) == NULL){
+	size_t i;
+
+	memset(&heap_stats, 0, sizeof(heap_stats));
+	/* we start with allocating pointers (8 bytes) to each segregated list and the bitmap */
+	if ((heap_ptr = mem_sbrk(HEAP_HDR_SIZE)) == (void *) -1){
         	return -1; /*if sbrk error*/
 	}
 
-	 /* Now we initialize each of these pointers as NULL */
-	PUT(heap_ptr + LIST_0, (size_t) NULL);
-	PUT(heap_ptr + LIST_1, (size_t) NULL);
-	PUT(heap_ptr + LIST_2, (size_t) NULL);
-	PUT(heap_ptr + LIST_3, (size_t) NULL);
-	PUT(heap_ptr + LIST_4, (size_t) NULL);
-	PUT(heap_ptr + LIST_5, (size_t) NULL);
-	PUT(heap_ptr + LIST_6, (size_t) NULL);
-	PUT(heap_ptr + LIST_7, (size_t) NULL);
-	PUT(heap_ptr + LIST_8, (size_t) NULL);
-	PUT(heap_ptr + LIST_9, (size_t) NULL);
-	PUT(heap_ptr + LIST_10, (size_t) NULL);
-	PUT(heap_ptr + LIST_11, (size_t) NULL);
+	 /* Now we initialize each of these pointers as NULL, all lists are empty */
+	for (i = 0; i < NO_OF_LISTS; i++){
+		PUT(heap_ptr + LIST_OFFSET(i), (size_t) NULL);
+	}
+	memset(heap_ptr + LIST_OFFSET(NO_OF_LISTS), 0, SEG_HDR_SIZE - LIST_OFFSET(NO_OF_LISTS)); /*clear the bitmaps*/
+#ifdef MM_SLAB
+	for (i = 0; i < SLAB_CLASSES; i++){
+		PUT(SLAB_HEAD(i), (size_t) NULL); /*no slabs yet*/
+	}
+	memset(slab_map, 0, sizeof(slab_map));
+#endif
 
 	/*Now we allocate space for padding, prologue block and epilogue*/
-	if ((heap_start = mem_sbrk(4 * WSIZE)) == NULL){ /*we need 4*WSIZE space as each of pad, prologue header and footer and epilogue are 4 byte each*/
+	if ((heap_start = mem_sbrk(4 * WSIZE)) == (void *) -1){ /*we need 4*WSIZE space as each of pad, prologue header and footer and epilogue are 4 byte each*/
 		return -1;
 	}
 	PUT_4(heap_start, 0); /*Alignment padding*/
@@ -206,9 +553,36 @@ int mm_init(void){
 	PUT_4(heap_start + (3 * WSIZE), PACK(0, PREV_ALLOC | ALLOC)); /*Epilogue header with information about previosu allocated block*/
 	/*Create an empty space of CHUNKSIZE bytes */
 	heap_start = heap_start + DSIZE;
+	heap_fresh = heap_start + DSIZE; /*payload of the first block*/
+	heap_grow = CHUNKSIZE;
+	check_cursor = NULL;
+#ifndef MM_RT
 	if (extend_heap(CHUNKSIZE) == NULL){
 	        return -1;
 	}
+#else
+	if (extend_heap(RT_POOL) == NULL){
+	        return -1;
+	}
+	/*fault the pool in now, not in malloc, in huge pages where the kernel has them*/
+	mem_hugepage(heap_ptr, (mem_heapsize() + MEM_HUGE_PAGE - 1) & ~(MEM_HUGE_PAGE - 1));
+	for (i = 0; i < mem_heapsize(); i += mem_pagesize()){
+		((volatile char *) heap_ptr)[i] = heap_ptr[i];
+	}
+#endif
+#ifdef MM_THREADS
+	memset(&tcache, 0, sizeof(tcache)); /*blocks cached before are gone with the old heap*/
+#endif
+#ifdef MM_QUICK
+	memset(&quick, 0, sizeof(quick)); /*and so are the blocks on the quick lists*/
+#endif
+#ifdef MM_PROFILE
+	if (prof_count > 0){ /*and so are the blocks sampled*/
+		madvise(prof_table, PROF_SLOTS * sizeof(prof_entry), MADV_DONTNEED);
+		prof_count = 0;
+		memset(prof_filter, 0, sizeof(prof_filter));
+	}
+#endif
 	return 0; /*successful exit*/
 }
 
@@ -219,113 +593,1556 @@ int mm_init(void){
  *  if not available, we extend the heap
  */
 void *malloc(size_t size){
+	void *bp = front_malloc(size);
 
-	size_t asize;           /* adjusted and aligned size */
-	size_t extendsize;          /* need to extend by this size */
-	char *bp;   /*pointer to block to be returned*/
-	
-	/* Ignore spurious requests */
-	if (size <= 0){
+	PROF_ALLOC(bp, size);
+	checkheap_step(0);
+	return bp;
+}
+
+/*
+ * front_malloc - malloc through the front end of the build
+ */
+static void *front_malloc(size_t size){
+#ifdef MM_THREADS
+	return tcache_malloc(size);
+#else
+#ifdef MM_SLAB
+	if (size > 0 && size <= SLAB_MAX_SIZE){
+		return slab_malloc(size);
+	}
+#endif
+#ifdef MM_QUICK
+	return quick_malloc(size);
+#else
+	return heap_malloc(size);
+#endif
+#endif
+}
+
+/*
+ *  free - This function frees the block pointed to by bp
+ *  and adds this block to the proper segreagated list of free blocks
+ */
+void free(void *bp){
+	PROF_FREE(bp);
+	if (bp != NULL && !in_heap(bp)){ /*only mapped blocks live outside the heap*/
+		large_free(bp);
+		return;
+	}
+	free_in_heap(bp, 0);
+	checkheap_step(0);
+}
+
+/*
+ * free_in_heap - free of a block that is not mapped, through the
+ * front end of the build. asize is the block size the caller worked out
+ * from the size it asked for, or 0 to read it from the header.
+ */
+static void free_in_heap(void *bp, size_t asize){
+#ifdef MM_THREADS
+	tcache_free(bp, asize);
+#else
+#ifdef MM_SLAB
+	if (is_slab_ptr(bp)){
+		slab_free(bp);
+		return;
+	}
+#endif
+#ifdef MM_QUICK
+	quick_free(bp);
+#else
+	heap_free(bp);
+#endif
+#endif
+}
+
+/*
+ *  realloc - Reallocates memory according to specific size
+ *  Change the size of the block by mallocing a new block and
+ *  freeing the old one
+ */
+void *realloc(void *oldptr, size_t size){
+	void *newptr;
+#ifdef MM_PROFILE
+	size_t old_size = oldptr != NULL ? malloc_usable_size(oldptr) : 0;
+	prof_entry sample;
+	int sampled = 0;
+
+	/*
+	 * A sampled block keeps its sample wherever it goes, and only the
+	 * bytes it grows by count, so a block grown a little at a time is
+	 * not sampled over and over
+	 */
+	if (oldptr != NULL && PROF_MAYBE(oldptr)){
+		sampled = prof_forget(oldptr, &sample);
+	}
+	newptr = front_realloc(oldptr, size);
+	if (sampled && (newptr != NULL || size != 0)){
+		prof_insert(newptr != NULL ? newptr : oldptr, newptr != NULL ? size : sample.size,
+			sample.stack, sample.depth);
+	}
+	else if (!sampled && size > old_size && (prof_countdown -= (long) (size - old_size)) < 0){
+		prof_sample(newptr, size);
+	}
+#else
+	newptr = front_realloc(oldptr, size);
+#endif
+	return newptr;
+}
+
+/*
+ * front_realloc - realloc of a block in the heap or a mapping, through
+ * the front end of the build
+ */
+static void *front_realloc(void *oldptr, size_t size){
+#ifdef MM_THREADS
+	char *newptr;
+#endif
+
+	if (oldptr != NULL && !in_heap(oldptr)){
+		return large_realloc(oldptr, size);
+	}
+#ifdef MM_THREADS
+	pthread_mutex_lock(&heap_lock);
+	newptr = heap_realloc(oldptr, size);
+	pthread_mutex_unlock(&heap_lock);
+	return newptr;
+#else
+#ifdef MM_SLAB
+	if (is_slab_ptr(oldptr) || (oldptr == NULL && size <= SLAB_MAX_SIZE)){
+		return slab_realloc(oldptr, size);
+	}
+#endif
+	return heap_realloc(oldptr, size);
+#endif
+}
+
+/*
+ * calloc - Allocates memory for an array of nmemb elements
+ * of size bytes each and returns a pointer to the allocated
+ * memory. The memory is set to zero before returning, except
+ * for memory we know is still zero: a new mapping, or the
+ * part of a heap block that was never handed out before.
+ */
+void *calloc(size_t nmemb, size_t size){
+	char *ptr;
+	size_t total_size;
+#ifndef MM_THREADS
+	char *fresh = heap_fresh; /*before malloc moves it*/
+#endif
+
+	if (size != 0 && nmemb > ~(size_t) 0 / size){
+		return NULL; /*nmemb * size overflows*/
+	}
+	total_size = (nmemb * size); /*Total size needed to be allocated*/
+	if (total_size >= MMAP_THRESHOLD){
+		ptr = large_malloc(total_size); /*mappings are zero filled*/
+		PROF_ALLOC(ptr, total_size);
+		return ptr;
+	}
+	if ((ptr = malloc(total_size)) == NULL){
 		return NULL;
 	}
-	/* Adjust the block size and include overhead of header and alignment */
-	if (size <= 2 * DSIZE){
-		asize = MIN_BLOCK_SIZE; /*Smallest aligned block*/
+#ifdef MM_THREADS
+	memset(ptr, 0, total_size); /*other threads move heap_fresh under our feet*/
+#else
+	zero_payload(ptr, total_size, fresh);
+#endif
+	return ptr;
+}
+
+/*
+ * memalign - Allocates size bytes whose address is a multiple of
+ * alignment, a power of two. The block is cut out of a free block big
+ * enough to hold it aligned, or out of the end of the heap, and the
+ * slack in front of it goes back to the lists as a free block.
+ */
+void *memalign(size_t alignment, size_t size){
+	char *bp;
+
+	if (size == 0 || (alignment & (alignment - 1)) != 0){
+		return NULL; /*not a power of two*/
+	}
+	if (alignment <= DSIZE){
+		return malloc(size); /*every block is aligned that much*/
+	}
+	if (size >= MMAP_THRESHOLD || alignment >= MMAP_THRESHOLD){
+		bp = large_memalign(alignment, size);
 	}
 	else{
-	/* Otherwise round up to next multiple of 8*/
-	asize = (((size_t) (size + WSIZE) + 7) & ~0x7);
+#ifdef MM_THREADS
+		pthread_mutex_lock(&heap_lock);
+#endif
+		bp = alloc_aligned(alignment, adjust_size(size));
+#ifdef MM_THREADS
+		pthread_mutex_unlock(&heap_lock);
+#endif
 	}
-	/* See if any free lists are availbale that can fit the requested size */
-	if ((bp = find_fit(asize)) != NULL) {
-        	place(bp, asize);       /* Block found, place it */
-        	return bp; /*return pointer to this block*/
+	PROF_ALLOC(bp, size);
+	return bp;
+}
+
+/*
+ * posix_memalign - memalign returning the block in *memptr, and EINVAL
+ * for an alignment that is not a power of two multiple of sizeof(void *)
+ * or ENOMEM when out of memory instead of NULL
+ */
+int posix_memalign(void **memptr, size_t alignment, size_t size){
+	void *bp;
+
+	if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0){
+		return EINVAL;
 	}
-	/* Otherwise extend the heap with the max of aligned size or CHUNKSIZE */
-	extendsize = MAX(asize, CHUNKSIZE);
-	if ((bp = extend_heap(extendsize)) == NULL){
-		return NULL; /*Cannot extend more*/
+	if (size == 0){
+		*memptr = NULL;
+		return 0;
+	}
+	if ((bp = memalign(alignment, size)) == NULL){
+		return ENOMEM;
+	}
+	*memptr = bp;
+	return 0;
+}
+
+/*
+ * aligned_alloc - The C11 name of memalign
+ */
+void *aligned_alloc(size_t alignment, size_t size){
+	return memalign(alignment, size);
+}
+
+/*
+ * free_sized - free for a caller that knows the size it gave malloc,
+ * calloc or realloc for the block (not memalign), as C23 free_sized.
+ * A block of less than MMAP_THRESHOLD bytes never has a mapping of its
+ * own, so the heap bounds are not looked up, and for a larger one the
+ * MMAPPED bit of its header tells. The size is passed on adjusted, so
+ * the thread cache files the block by it without reading the header.
+ * The block may be up to MIN_BLOCK_SIZE - DSIZE bytes larger, where
+ * place or block_shrink left it the slack too small to split off; the
+ * heap free path, which clears the header's ALLOC bit and so reads it
+ * anyway, takes the exact size from there.
+ */
+void free_sized(void *bp, size_t size){
+	if (bp == NULL){
+		return;
+	}
+	PROF_FREE(bp);
+	if (size >= MMAP_THRESHOLD && (GET_4(HDRP(bp)) & MMAPPED)){
+		large_free(bp);
+		return;
+	}
+	free_in_heap(bp, adjust_size(size));
+}
+
+/*
+ * free_many - Free the n blocks in ptrs, which may hold NULLs and is
+ * left reordered. The pointers are sorted by address, so a run of
+ * blocks that lie back to back in the heap is freed as one block: one
+ * list insertion and one coalesce per run instead of per block. In the
+ * thread safe build the heap lock is taken once for all of them, and
+ * the blocks go straight back to the heap instead of the thread cache.
+ */
+void free_many(void **ptrs, size_t n){
+	char **p = (char **) ptrs;
+	char *lo = mem_heap_lo(), *hi = mem_heap_hi(); /*a trim below leaves no block above hi*/
+	char *bp;
+	size_t i, size;
+
+#ifdef MM_PROFILE
+	for (i = 0; i < n; i++){
+		PROF_FREE(p[i]);
+	}
+#endif
+	sort_ptrs(p, n);
+#ifdef MM_THREADS
+	pthread_mutex_lock(&heap_lock);
+#endif
+	for (i = 0; i < n; i++){
+		if ((bp = p[i]) == NULL){
+			continue;
+		}
+		if (bp < lo || bp > hi){
+			large_free(bp);
+			continue;
+		}
+#ifdef MM_SLAB
+		if (is_slab_ptr(bp)){
+			slab_free(bp);
+			continue;
+		}
+#endif
+		size = GET_SIZE(HDRP(bp));
+		while (i + 1 < n && p[i + 1] == bp + size){ /*the next block is freed too*/
+			size += GET_SIZE(HDRP(p[++i]));
+		}
+		free_blocks(bp, size);
+	}
+#ifdef MM_THREADS
+	pthread_mutex_unlock(&heap_lock);
+#endif
+}
+
+/*
+ * malloc_batch - Allocate n blocks of size bytes each into out and
+ * return how many it got, fewer than n only when memory runs out. The
+ * blocks are carved back to back out of one free block found (or made
+ * at the end of the heap) for all of them, so a whole batch costs one
+ * search and one list removal. Only when no block that big can be had
+ * is the batch split over smaller ones, and then sorted, so out is in
+ * address order either way. Each block is an ordinary one, freed on
+ * its own.
+ */
+size_t malloc_batch(size_t size, size_t n, void **out){
+	size_t asize, i = 0, k;
+	int regions = 0; /*free blocks carved*/
+	char *bp;
+
+	if (size == 0 || size >= MMAP_THRESHOLD){ /*nothing to carve, or all mappings*/
+		while (i < n && (out[i] = malloc(size)) != NULL){
+			i++;
+		}
+		return i;
+	}
+	asize = adjust_size(size);
+	k = MAX(BATCH_MAX / asize, 1);
+#ifdef MM_THREADS
+	pthread_mutex_lock(&heap_lock);
+#endif
+	while (i < n){
+		k = MIN(k, n - i);
+		if ((bp = find_region(k * asize)) == NULL){
+			if (k == 1){
+				break; /*out of memory*/
+			}
+			k /= 2; /*try a smaller region*/
+			continue;
+		}
+		i += carve(bp, asize, k, out + i);
+		regions++;
+	}
+#ifdef MM_THREADS
+	pthread_mutex_unlock(&heap_lock);
+#endif
+	if (regions > 1){
+		sort_ptrs((char **) out, i);
+	}
+#ifdef MM_PROFILE
+	for (k = 0; k < i; k++){
+		PROF_ALLOC(out[k], size);
+	}
+#endif
+	return i;
+}
+
+/*
+ * malloc_usable_size - Number of bytes the caller may use in the block
+ * bp, which is at least what was asked for: all of it up to the next header
+ */
+size_t malloc_usable_size(void *bp){
+	if (bp == NULL){
+		return 0;
+	}
+	if (!in_heap(bp)){
+		return MMAP_LEN(bp) - MMAP_LEAD(bp);
+	}
+#ifdef MM_SLAB
+	if (is_slab_ptr(bp)){
+		return SLAB_OF(bp)->slot_size;
+	}
+#endif
+	return GET_SIZE(HDRP(bp)) - WSIZE;
+}
+
+/*
+ * mm_stats - Copy the counters of the heap into st. The per class free
+ * counts are summed here, the allocated bytes are what the blocks of the
+ * heap hold besides them; blocks in thread caches, on quick lists and
+ * slabs count as allocated.
+ */
+void mm_stats(struct mm_heap_stats *st){
+	size_t i;
+
+#ifdef MM_THREADS
+	pthread_mutex_lock(&heap_lock);
+#endif
+	*st = heap_stats;
+	st->heap_size = mem_heapsize();
+#ifdef MM_THREADS
+	pthread_mutex_unlock(&heap_lock);
+#endif
+	st->mapped_bytes = __atomic_load_n(&heap_stats.mapped_bytes, __ATOMIC_RELAXED);
+	st->mapped_blocks = __atomic_load_n(&heap_stats.mapped_blocks, __ATOMIC_RELAXED);
+	st->free_bytes = st->free_blocks = 0;
+	for (i = 0; i < MM_SIZE_CLASSES; i++){
+		st->free_bytes += st->class_bytes[i];
+		st->free_blocks += st->class_blocks[i];
+	}
+	st->alloc_bytes = st->heap_size - HEAP_HDR_SIZE - 4 * WSIZE - st->free_bytes;
+}
+
+/*
+ * mm_heap_walk - Call visit on every block of the heap in address order,
+ * from the first block after the prologue to the epilogue, with its size
+ * and whether it is allocated. Blocks with mappings of their own are not
+ * in the heap and are not visited. The heap is locked in the thread safe
+ * build, so visit must not call the allocator.
+ */
+void mm_heap_walk(void (*visit)(void *arg, void *bp, size_t size, int alloc), void *arg){
+	char *blk;
+
+#ifdef MM_THREADS
+	pthread_mutex_lock(&heap_lock);
+#endif
+	for (blk = NEXT_BLKP(heap_start); GET_SIZE(HDRP(blk)) != 0; blk = NEXT_BLKP(blk)){
+		visit(arg, blk, GET_SIZE(HDRP(blk)), GET_ALLOC(HDRP(blk)) != 0);
+	}
+#ifdef MM_THREADS
+	pthread_mutex_unlock(&heap_lock);
+#endif
+}
+
+/*
+ * Regions
+ * -------
+ * A region is a chain of chunks, each an allocated block of the heap that
+ * starts with a pointer to the chunk before it. The first chunk holds the
+ * region itself after that pointer. Allocating bumps top towards end in
+ * the last chunk; when it runs out the chunk is grown in place into a free
+ * block after it or the end of the heap, and only when neither is there
+ * does a new chunk start the chain over. Regions go straight to the heap,
+ * past the thread caches, quick lists and slabs, and one region must not
+ * be used by two threads at once.
+ */
+struct mm_region {
+	char *chunk;  /*last chunk of the chain*/
+	char *top;    /*next free byte in it*/
+	char *end;    /*end of its payload*/
+	size_t grow;  /*bytes of the next chunk*/
+};
+
+/*
+ * mm_region_create - Make a region with room for size bytes of objects
+ * before it has to grow, REGION_CHUNK if size is 0. Returns NULL when
+ * out of memory.
+ */
+struct mm_region *mm_region_create(size_t size){
+	struct mm_region *r;
+	char *bp;
+	size_t asize;
+
+	size = size ? size : REGION_CHUNK;
+	if (size >= BATCH_MAX){
+		return NULL; /*no block that big*/
+	}
+	asize = adjust_size(DSIZE + sizeof(struct mm_region) + size);
+#ifdef MM_THREADS
+	pthread_mutex_lock(&heap_lock);
+#endif
+	bp = alloc_block(asize);
+#ifdef MM_THREADS
+	pthread_mutex_unlock(&heap_lock);
+#endif
+	if (bp == NULL){
+		return NULL;
+	}
+	*(char **) bp = NULL; /*the first chunk*/
+	r = (struct mm_region *) (bp + DSIZE);
+	r->chunk = bp;
+	r->top = (char *) (r + 1);
+	r->end = bp + GET_SIZE(HDRP(bp)) - WSIZE;
+	r->grow = MIN(MAX(2 * size, REGION_CHUNK), REGION_CHUNK_MAX);
+	return r;
+}
+
+/*
+ * mm_region_alloc - Allocate size bytes, aligned like malloc, from the
+ * region r. They live until the region is destroyed and cannot be freed
+ * or reallocated on their own. Returns NULL when out of memory.
+ */
+void *mm_region_alloc(struct mm_region *r, size_t size){
+	char *bp;
+
+	if (size == 0 || size >= BATCH_MAX){
+		return NULL;
+	}
+	size = (size + DSIZE - 1) & ~(size_t) (DSIZE - 1);
+	if (size > (size_t) (r->end - r->top) && region_grow(r, size) < 0){
+		return NULL;
+	}
+	bp = r->top;
+	r->top += size;
+	return bp;
+}
+
+/*
+ * mm_region_destroy - Free every object of the region r, and r itself,
+ * by freeing its chunks to the heap, where each coalesces with its free
+ * neighbours
+ */
+void mm_region_destroy(struct mm_region *r){
+	char *chunk, *prev;
+
+	if (r == NULL){
+		return;
+	}
+#ifdef MM_THREADS
+	pthread_mutex_lock(&heap_lock);
+#endif
+	for (chunk = r->chunk; chunk != NULL; chunk = prev){
+		prev = *(char **) chunk;
+		free_blocks(chunk, GET_SIZE(HDRP(chunk)));
+	}
+#ifdef MM_THREADS
+	pthread_mutex_unlock(&heap_lock);
+#endif
+}
+
+/*
+ * region_grow - Make room for size more bytes in the last chunk of r:
+ * grow the chunk in place if the heap lets it, or chain a new chunk.
+ * The next growth will be twice as much, up to REGION_CHUNK_MAX.
+ * Returns 0, or -1 when out of memory.
+ */
+static int region_grow(struct mm_region *r, size_t size){
+	size_t chunk_size = GET_SIZE(HDRP(r->chunk));
+	size_t more = MAX(r->grow, size + DSIZE); /*room for the link if it is a new chunk*/
+	char *bp;
+	int ok = 0;
+
+#ifdef MM_THREADS
+	pthread_mutex_lock(&heap_lock);
+#endif
+	if (chunk_size + more < BATCH_MAX && grow_block(r->chunk, adjust_size(chunk_size + more))){
+		r->end = r->chunk + GET_SIZE(HDRP(r->chunk)) - WSIZE; /*top stays where it is*/
+	}
+	else if ((bp = alloc_block(adjust_size(more))) != NULL){
+		*(char **) bp = r->chunk;
+		r->chunk = bp;
+		r->top = bp + DSIZE;
+		r->end = bp + GET_SIZE(HDRP(bp)) - WSIZE;
+	}
+	else{
+		ok = -1;
+	}
+#ifdef MM_THREADS
+	pthread_mutex_unlock(&heap_lock);
+#endif
+	r->grow = MIN(2 * r->grow, REGION_CHUNK_MAX);
+	return ok;
+}
+
+#ifndef MM_THREADS
+/*
+ * zero_payload - Zero the first size bytes of bp, a block just allocated
+ * when the heap had never handed out memory at or above fresh. The list
+ * links of a free block starting at fresh may lie just above it, and so
+ * may the footer of the free block bp was taken from, if bp is all of it;
+ * everything else above fresh is still zero.
+ */
+static void zero_payload(char *bp, size_t size, char *fresh){
+	char *end = bp + size;
+	char *clean = MAX(fresh, bp) + 2 * LINK_SIZE; /*zero from here on, but for the footer*/
+	char *ftr;
+
+	if (end <= clean){
+		memset(bp, 0, size);
+		return;
+	}
+	memset(bp, 0, clean - bp);
+	ftr = MAX(FTRP(bp), clean);
+	if (ftr < end){
+		memset(ftr, 0, end - ftr);
+	}
+}
+#endif
+
+/*
+ * heap_malloc - Allocate a block for size bytes of payload from the
+ * segregated lists, growing the heap if nothing fits
+ */
+static void *heap_malloc(size_t size){
+	/* Ignore spurious requests */
+	if (size <= 0){
+		return NULL;
+	}
+	if (size >= MMAP_THRESHOLD){
+		return large_malloc(size);
+	}
+	return alloc_block(adjust_size(size));
+}
+
+/*
+ * adjust_size - Size of the block needed for size bytes of payload,
+ * including the header and rounded up to the alignment
+ */
+static size_t adjust_size(size_t size){
+	/* Adjust the block size and include overhead of header and alignment */
+	if (size + WSIZE <= MIN_BLOCK_SIZE){
+		return MIN_BLOCK_SIZE; /*Smallest aligned block*/
+	}
+	/* Otherwise round up to next multiple of 8*/
+	return (((size_t) (size + WSIZE) + 7) & ~0x7);
+}
+
+/*
+ * alloc_block - Find or make a free block of at least asize
+ * bytes, allocate asize bytes of it and return it
+ */
+static void *alloc_block(size_t asize){
+	char *bp;   /*pointer to block to be returned*/
+
+	if ((bp = find_region(asize)) == NULL){
+		return NULL; /*Cannot extend more*/
+	}
+#ifdef MM_HUGE
+	if (asize > HOT_MAX){
+		return place_high(bp, asize);
+	}
+#endif
+	place(bp, asize);           /* Place the block */
+	return bp;
+}
+
+/*
+ * find_region - Find a free block of at least asize bytes, or make
+ * one at the end of the heap. It is left on its free list.
+ */
+static char *find_region(size_t asize){
+	char *bp;   /*pointer to block to be returned*/
+	char *top;  /*payload of the block extend_heap would make*/
+	size_t tail; /*bytes of the free block at the end of the heap*/
+
+	/* See if any free lists are availbale that can fit the requested size */
+	if ((bp = find_fit(asize)) != NULL) {
+        	return bp; /*return pointer to this block*/
+	}
+#ifdef MM_QUICK
+	/* A larger request that misses coalesces the quick lists and looks again */
+	if (asize > QL_MAX_SIZE && quick.blocks > 0){
+		quick_flush();
+		if ((bp = find_fit(asize)) != NULL){
+			return bp;
+		}
+	}
+#endif
+	/* Otherwise extend the heap, extend_heap merges the new space with a free block at its end */
+	top = (char *) mem_heap_hi() + 1;
+	tail = GET_PREV_ALLOC(HDRP(top)) ? 0 : GET_SIZE(HDRP(top) - WSIZE);
+	if (tail >= asize){
+		return PREV_BLKP(top); /*a good fit search may pass over it*/
+	}
+#ifdef MM_RT
+	return NULL; /*the pool is all there is*/
+#else
+	return extend_heap(grow_size(asize - tail));
+#endif
+}
+
+/*
+ * grow_size - Number of bytes to extend the heap by when need more are
+ * needed at its end. Each extension doubles the next one, so a program
+ * building up its heap calls mem_sbrk O(log n) times instead of once per
+ * CHUNKSIZE bytes, but an extension is never more than GROW_MAX bytes
+ * nor more than 1/GROW_FRACTION of the heap, so a small heap has little
+ * slack at its end. A trim starts over at CHUNKSIZE.
+ */
+static size_t grow_size(size_t need){
+	size_t cap = MIN(GROW_MAX, mem_heapsize() / GROW_FRACTION);
+	size_t size = MAX(need, heap_grow);
+
+	heap_grow = MAX(CHUNKSIZE, MIN(2 * heap_grow, cap)) & ~(size_t) (DSIZE - 1);
+	return size;
+}
+
+/*
+ * grow_block - Try to grow the allocated block bp to asize bytes where it
+ * is: by taking in the next block if that is free and big enough, or, if
+ * bp is the last block of the heap (maybe followed by a free block), by
+ * extending the heap under it. Returns 1 on success, with the part not
+ * needed split off again, and 0 if bp has to move. realloc asks it for
+ * less than MMAP_THRESHOLD bytes, larger blocks move to mappings, but
+ * region_grow for up to BATCH_MAX: heap blocks that big are fine, and so
+ * is the extension, well below the INT_MAX extend_heap refuses.
+ */
+static int grow_block(char *bp, size_t asize){
+	size_t size = GET_SIZE(HDRP(bp));
+	char *next = NEXT_BLKP(bp);
+	size_t next_size = GET_ALLOC(HDRP(next)) ? 0 : GET_SIZE(HDRP(next)); /*free bytes right after bp*/
+
+	if (size + next_size < asize){
+		if (GET_SIZE(HDRP(next_size ? NEXT_BLKP(next) : next)) != 0){
+			return 0; /*not at the end of the heap, no room to grow*/
+		}
+#ifdef MM_RT
+		return 0; /*the pool cannot grow*/
+#endif
+		/*extend_heap coalesces the new space with the free block after bp*/
+		if (extend_heap(grow_size(asize - size - next_size)) == NULL){
+			return 0;
+		}
+		next_size = GET_SIZE(HDRP(next));
+	}
+	block_rem_free(next, next_size);
+	block_set_alloc(bp, size + next_size); /*and tell the block after it*/
+	CHECK_MERGED(bp, size + next_size);
+	block_shrink(bp, asize);
+	heap_fresh = MAX(heap_fresh, NEXT_BLKP(bp));
+	return 1;
+}
+
+/*
+ * alloc_aligned - Allocate a block of asize bytes whose payload is aligned
+ * to align bytes (a power of two, at least DSIZE). A free block with room
+ * for the payload and at least MIN_BLOCK_SIZE bytes in front of it is taken
+ * from the lists; failing that the heap is grown just enough to end with
+ * such a payload, so aligned blocks allocated in a row sit back to back.
+ * The leading slack goes back as a free block, and so does whatever is
+ * left behind the new block.
+ */
+static void *alloc_aligned(size_t align, size_t asize){
+	char *bp; /*block as allocated*/
+	char *abp; /*aligned block inside it*/
+	char *top; /*payload of the block extend_heap would make*/
+	size_t size, lead;
+
+	if ((bp = find_fit(asize + align + MIN_BLOCK_SIZE)) == NULL){
+#ifdef MM_RT
+		return NULL; /*the pool cannot grow*/
+#endif
+		top = (char *) mem_heap_hi() + 1;
+		bp = GET_PREV_ALLOC(HDRP(top)) ? top : PREV_BLKP(top); /*extend_heap merges with a free last block*/
+		abp = align_payload(bp, align);
+		if ((bp = extend_heap(abp + asize > top + MIN_BLOCK_SIZE ? (size_t) (abp + asize - top) : MIN_BLOCK_SIZE)) == NULL){
+			return NULL;
+		}
+	}
+	place(bp, GET_SIZE(HDRP(bp))); /*take all of it, the ends are given back below*/
+	abp = align_payload(bp, align);
+	if (abp != bp){
+		lead = abp - bp;
+		size = GET_SIZE(HDRP(bp));
+		PUT_4(HDRP(abp), PACK(size - lead, ALLOC)); /*the slack before it is free*/
+		block_set_free(bp, lead);
+		heap_stats.splits++;
+		block_coalesce(bp);
+	}
+	block_shrink(abp, asize);
+	return abp;
+}
+
+/*
+ * align_payload - First payload address in the block bp aligned to
+ * align bytes, leaving either nothing or room for a free block in front
+ */
+static char *align_payload(char *bp, size_t align){
+	char *abp = (char *) (((size_t) bp + align - 1) & ~(align - 1));
+
+	if (abp != bp && (size_t) (abp - bp) < MIN_BLOCK_SIZE){
+		abp += align; /*slack too small to be a free block*/
+	}
+	return abp;
+}
+
+/*
+ * heap_free - Mark the block free, put it in its segregated list
+ * and coalesce it with its neighbours
+ */
+static void heap_free(void *bp){
+	if (bp == NULL){
+		return;
+	}
+	free_blocks(bp, GET_SIZE(HDRP(bp)));
+}
+
+/*
+ * free_blocks - Free the size bytes of allocated blocks that lie back
+ * to back from bp as one free block, and coalesce it with its neighbours
+ */
+static void free_blocks(char *bp, size_t size){
+	assert(GET_ALLOC(HDRP(bp))); /*not freed twice*/
+	CHECK_MERGED(bp, size);
+	block_set_free(bp, size); /*and clear the prev allocated bit of the next block*/
+	bp = block_coalesce(bp); /*coalesce if possible, and put it on its seg list*/
+#ifndef MM_RT
+	if (GET_SIZE(HDRP(bp)) > TRIM_THRESHOLD && GET_SIZE(HDRP(NEXT_BLKP(bp))) == 0){
+		trim_heap(bp); /*too much free space at the top of the heap*/
+	}
+#endif
+}
+
+/*
+ * sort_ptrs - Sort n pointers by address in place, NULLs (which may be
+ * left anywhere) aside. Pointers freed in the order they were allocated
+ * often are sorted already; otherwise a radix sort on the bytes of
+ * their offset from the lowest, which needs no memory of its own.
+ */
+static void sort_ptrs(char **p, size_t n){
+	char *lo = NULL, *hi = NULL;
+	size_t i, m = 0;
+	int shift = 0;
+
+	for (i = 1; i < n && p[i - 1] <= p[i]; i++)
+		;
+	if (i >= n){
+		return;
+	}
+	for (i = 0; i < n; i++){ /*NULLs to the end, the rest keep their order*/
+		if (p[i] == NULL){
+			continue;
+		}
+		if (lo == NULL || p[i] < lo){
+			lo = p[i];
+		}
+		if (p[i] > hi){
+			hi = p[i];
+		}
+		p[m++] = p[i];
+	}
+	for (i = m; i < n; i++){
+		p[i] = NULL;
+	}
+	while (shift + 8 < (int) (8 * sizeof(size_t)) && (size_t) (hi - lo) >> (shift + 8) != 0){
+		shift += 8;
+	}
+	radix_sort(p, m, lo, shift);
+}
+
+/*
+ * radix_sort - Sort p[0..n-1], which all lie at lo or above, by the
+ * byte of their offset from lo at shift and then the bytes below it.
+ * The buckets are permuted in place (American flag sort), and short
+ * ones are finished with an insertion sort.
+ */
+static void radix_sort(char **p, size_t n, char *lo, int shift){
+	size_t count[256], next[256];
+	size_t i, j, b, d;
+	char *x, *y;
+
+	if (n <= 32){
+		for (i = 1; i < n; i++){
+			x = p[i];
+			for (j = i; j > 0 && p[j - 1] > x; j--){
+				p[j] = p[j - 1];
+			}
+			p[j] = x;
+		}
+		return;
+	}
+	memset(count, 0, sizeof(count));
+	for (i = 0; i < n; i++){
+		count[RADIX_KEY(p[i], lo, shift)]++;
+	}
+	for (b = 0, i = 0; b < 256; i += count[b++]){
+		next[b] = i;
+	}
+	for (b = 0, i = 0; b < 256; i += count[b++]){
+		while (next[b] < i + count[b]){
+			x = p[next[b]];
+			while ((d = RADIX_KEY(x, lo, shift)) != b){ /*swap x into its bucket*/
+				y = p[next[d]];
+				p[next[d]++] = x;
+				x = y;
+			}
+			p[next[b]++] = x;
+		}
+	}
+	if (shift == 0){
+		return;
+	}
+	for (b = 0, i = 0; b < 256; i += count[b++]){
+		if (count[b] > 1){
+			radix_sort(p + i, count[b], lo, shift - 8);
+		}
+	}
+}
+
+/*
+ * heap_realloc - realloc on the heap itself. A smaller block is cut
+ * down where it is, and a larger one grows in place into a free next
+ * block or the end of the heap if it can. Only otherwise we allocate a
+ * new block, copy the old payload and free the old block. A size of
+ * MMAP_THRESHOLD bytes or more always moves to a mapping of its own,
+ * and one too big to have a block size at all fails.
+ */
+static void *heap_realloc(void *oldptr, size_t size){
+
+        size_t oldsize; /* Hold the payload bytes of the block pointed to by oldptr  */
+        size_t asize;   /* adjusted size of the new block */
+        char *newptr;   /* Points to the newly alllocated block */
+
+        if(size == 0){ /*If a size of 0 has to be allocated, just free the oldptr*/
+                heap_free(oldptr);
+                return NULL;
+        }
+
+        /*If oldptr is NULL, call a simple malloc for size then*/
+        if(oldptr == NULL){
+                return heap_malloc(size);
+        }
+        if(size > SIZE_MAX - DSIZE){ /*adjust_size would wrap around*/
+                return NULL;
+        }
+        if(size >= MMAP_THRESHOLD){ /*a block this big gets a mapping, it is never grown in the heap*/
+                newptr = large_malloc(size);
+        }
+        else{
+                asize = adjust_size(size);
+                /* If requested size is smaller than old one, old ptr will suffice, give back the rest */
+                if(asize <= GET_SIZE(HDRP(oldptr))){
+                        block_shrink(oldptr, asize);
+                        return oldptr;
+                }
+                /* Grow into the next block or the end of the heap without copying */
+                if(grow_block(oldptr, asize)){
+                        return oldptr;
+                }
+                /* Otherwise, allocated a fresh new block, copy previous bytes and delete the oldptr Need more memory */
+                newptr = (char *) alloc_block(asize);
+        }
+        if(!newptr){
+                return NULL;
+        }
+        /* Calculate payload bytes contained in oldptr, only a header precedes them */
+        oldsize = GET_SIZE(HDRP(oldptr)) - WSIZE;
+        memcpy(newptr, oldptr, oldsize);
+        heap_free(oldptr);
+        return newptr;
+}
+
+/*
+ * Large blocks
+ * ------------
+ * large_malloc, large_free and large_realloc work on mapped blocks
+ * only and need no lock: each mapped block is private to its owner.
+ */
+
+/*
+ * large_malloc - Give a block of size bytes a mapping of its own
+ */
+static void *large_malloc(size_t size){
+	return large_memalign(DSIZE, size);
+}
+
+/*
+ * large_memalign - Give a block of size bytes aligned to align bytes a
+ * mapping of its own (block_map)
+ */
+static void *large_memalign(size_t align, size_t size){
+#ifdef MM_RT
+	return NULL; /*a mapping is a system call*/
+#endif
+	return block_map(align, size);
+}
+
+/*
+ * large_free - Unmap the mapping of block bp
+ */
+static void large_free(void *bp){
+	block_unmap(bp);
+}
+
+/*
+ * large_realloc - realloc of a mapped block. It is resized with
+ * block_remap, which moves pages instead of copying bytes, unless the
+ * new size is small enough for the heap, where it is copied to. That
+ * block comes from front_malloc, not malloc: realloc does the profiler's
+ * accounting for the whole call.
+ */
+static void *large_realloc(void *oldptr, size_t size){
+	char *newptr;
+
+	if (size == 0){
+		large_free(oldptr);
+		return NULL;
+	}
+	if (size < MMAP_THRESHOLD){
+		if ((newptr = front_malloc(size)) == NULL){
+			return NULL;
+		}
+		memcpy(newptr, oldptr, size); /*smaller than the old payload*/
+		large_free(oldptr);
+		return newptr;
+	}
+	return block_remap(oldptr, size);
+}
+
+#ifndef MM_RT
+/*
+ * trim_heap - bp is a free block at the top of the heap. Shrink it to
+ * TOP_PAD bytes and give the rest of the heap back with mem_shrink.
+ * With -DMM_HUGE it keeps up to the next huge page boundary instead.
+ */
+static void trim_heap(char *bp){
+	size_t size = GET_SIZE(HDRP(bp));
+#ifndef MM_HUGE
+	size_t keep = TOP_PAD;
+#else
+	size_t keep = (((size_t) bp + TOP_PAD + MEM_HUGE_PAGE - 1) & ~(MEM_HUGE_PAGE - 1)) - (size_t) bp;
+#endif
+	size_t release = size - keep;
+
+	block_rem_free(bp, size);
+	block_set_free(bp, keep);
+	PUT_4(HDRP(NEXT_BLKP(bp)), PACK(0, ALLOC)); /*new epilogue, the block before it is free*/
+	block_add_free(bp, keep);
+	mem_shrink(release);
+	if (check_cursor > (char *) bp + keep){
+		check_cursor = NULL; /*it was given back*/
+	}
+	heap_stats.trims++;
+	heap_grow = CHUNKSIZE; /*the heap is shrinking, not growing*/
+	/*the whole pages given back read as zero again, the rest of the last page does not*/
+	heap_fresh = MIN(heap_fresh, (char *) (((size_t) mem_heap_hi() + mem_pagesize()) & ~(mem_pagesize() - 1)));
+}
+#endif
+
+#ifdef MM_THREADS
+/*
+ * Thread safe front end (-DMM_THREADS)
+ * ------------------------------------
+ * The heap and its segregated lists are shared and guarded by heap_lock.
+ * In front of them every thread keeps a cache of small blocks, one LIFO
+ * list per 8 byte size class up to TC_MAX_SIZE. Cached blocks stay marked
+ * allocated in the heap (so nothing coalesces with them) and are linked
+ * through their first payload word, so a small malloc or free only touches
+ * the calling thread's cache. An empty class is refilled with TC_BATCH
+ * blocks under one lock, a full class flushes TC_BATCH blocks back to the
+ * lists the same way, and the whole cache is flushed when the thread exits.
+ */
+
+/*
+ * tcache_register - Arrange for this thread's cache to be flushed
+ * when the thread exits, the first time the thread uses its cache
+ */
+static void tcache_register(void){
+	tcache.registered = 1; /*first, pthread_setspecific may call malloc*/
+	pthread_once(&tcache_once, tcache_make_key);
+	pthread_setspecific(tcache_key, &tcache);
+}
+
+static void tcache_make_key(void){
+	pthread_key_create(&tcache_key, tcache_destroy);
+}
+
+/*
+ * tcache_destroy - Thread exit handler, return every cached block to the heap
+ */
+static void tcache_destroy(void *arg){
+	tcache_t *tc = (tcache_t *) arg;
+	size_t c;
+
+	pthread_mutex_lock(&heap_lock);
+	for (c = 0; c < TC_CLASSES; c++){
+		while (tc->head[c] != NULL){
+			char *bp = tc->head[c];
+
+			tc->head[c] = (char *) GET(bp);
+			heap_free(bp);
+		}
+		tc->count[c] = 0;
+	}
+	pthread_mutex_unlock(&heap_lock);
+}
+
+/*
+ * tcache_refill - Allocate TC_BATCH blocks of asize bytes from
+ * the heap in one go and cache them in class c
+ */
+static void tcache_refill(size_t c, size_t asize){
+	char *bp;
+	int i;
+
+	if (!tcache.registered){
+		tcache_register();
+	}
+	pthread_mutex_lock(&heap_lock);
+	for (i = 0; i < TC_BATCH; i++){
+		if ((bp = alloc_block(asize)) == NULL){
+			break; /*out of memory, make do with what we have*/
+		}
+		PUT(bp, (size_t) tcache.head[c]);
+		tcache.head[c] = bp;
+		tcache.count[c]++;
+	}
+	pthread_mutex_unlock(&heap_lock);
+}
+
+/*
+ * tcache_flush - Free TC_BATCH blocks of class c to the heap in one go
+ */
+static void tcache_flush(size_t c){
+	int i;
+
+	pthread_mutex_lock(&heap_lock);
+	for (i = 0; i < TC_BATCH && tcache.head[c] != NULL; i++){
+		char *bp = tcache.head[c];
+
+		tcache.head[c] = (char *) GET(bp);
+		tcache.count[c]--;
+		heap_free(bp);
+	}
+	pthread_mutex_unlock(&heap_lock);
+}
+
+/*
+ * tcache_malloc - malloc of the thread safe build, small blocks come
+ * from the thread's cache and everything else from the locked heap
+ */
+static void *tcache_malloc(size_t size){
+	size_t asize, c;
+	char *bp;
+
+	if (size == 0){
+		return NULL;
+	}
+	if (size >= MMAP_THRESHOLD){
+		return large_malloc(size);
+	}
+	asize = adjust_size(size);
+	if (asize > TC_MAX_SIZE){ /*too big to cache*/
+		pthread_mutex_lock(&heap_lock);
+		bp = alloc_block(asize);
+		pthread_mutex_unlock(&heap_lock);
+		return bp;
+	}
+	c = TC_CLASS(asize);
+	if (tcache.head[c] == NULL){
+		tcache_refill(c, asize);
+		if (tcache.head[c] == NULL){
+			return NULL;
+		}
+	}
+	bp = tcache.head[c];
+	tcache.head[c] = (char *) GET(bp);
+	tcache.count[c]--;
+	return bp;
+}
+
+/*
+ * tcache_free - free of the thread safe build, a small block goes to the
+ * cache of its size class, a large one straight back to the locked heap.
+ * The class is that of asize, if the caller knows it, and else of the
+ * header's size; a block a little larger than its class serves a malloc
+ * of the class all the same, as those refilled with alloc_block may be.
+ */
+static void tcache_free(void *bp, size_t asize){
+	size_t size, c;
+
+	if (bp == NULL){
+		return;
+	}
+	assert(asize == 0 || GET_SIZE(HDRP(bp)) - asize < MIN_BLOCK_SIZE); /*the size it was allocated with*/
+	size = asize ? asize : GET_SIZE(HDRP(bp));
+	if (size > TC_MAX_SIZE){
+		pthread_mutex_lock(&heap_lock);
+		heap_free(bp);
+		pthread_mutex_unlock(&heap_lock);
+		return;
+	}
+	c = TC_CLASS(size);
+	if (tcache.count[c] >= TC_LIMIT){
+		tcache_flush(c);
+	}
+	else if (!tcache.registered){
+		tcache_register();
+	}
+	PUT(bp, (size_t) tcache.head[c]);
+	tcache.head[c] = bp;
+	tcache.count[c]++;
+}
+#endif
+
+#ifdef MM_QUICK
+/*
+ * Quick list front end (-DMM_QUICK)
+ * ---------------------------------
+ * A freed block of up to QL_MAX_SIZE bytes is not coalesced but pushed
+ * on the LIFO list of its size class, and a malloc of that size pops it
+ * again, so a program that frees and allocates the same sizes over and
+ * over never splits and merges the same block. Blocks on the lists stay
+ * marked allocated in the heap and are linked through their first payload
+ * word, as in the thread caches. The coalescing is deferred to
+ * quick_flush, which frees all of them in one pass when a list reaches
+ * QL_LIMIT blocks or a request too large for the lists finds no fit.
+ */
+
+/*
+ * quick_malloc - malloc with quick lists, a block of the exact size
+ * from its list if there is one, else from the segregated lists
+ */
+static void *quick_malloc(size_t size){
+	size_t asize, c;
+	char *bp;
+
+	if (size == 0 || size >= MMAP_THRESHOLD){
+		return heap_malloc(size);
+	}
+	asize = adjust_size(size);
+	if (asize <= QL_MAX_SIZE && (bp = quick.head[c = QL_CLASS(asize)]) != NULL){
+		quick.head[c] = (char *) GET(bp);
+		quick.count[c]--;
+		quick.blocks--;
+		return bp;
+	}
+	return alloc_block(asize);
+}
+
+/*
+ * quick_free - free with quick lists, a small block goes on the list
+ * of its size, a larger one is freed and coalesced right away
+ */
+static void quick_free(void *bp){
+	size_t size, c;
+
+	if (bp == NULL){
+		return;
+	}
+	size = GET_SIZE(HDRP(bp));
+	if (size > QL_MAX_SIZE || at_top(bp)){
+		heap_free(bp);
+		return;
+	}
+	c = QL_CLASS(size);
+	if (quick.count[c] >= QL_LIMIT){
+		quick_flush();
+	}
+	PUT(bp, (size_t) quick.head[c]);
+	quick.head[c] = bp;
+	quick.count[c]++;
+	quick.blocks++;
+}
+
+/*
+ * at_top - Whether bp is the last block of the heap, or the free block
+ * after it is; such a block is coalesced right away, so the heap can
+ * still shrink when a program frees everything
+ */
+static int at_top(char *bp){
+	char *next = NEXT_BLKP(bp);
+
+	return GET_SIZE(HDRP(next)) == 0 || (!GET_ALLOC(HDRP(next)) && GET_SIZE(HDRP(NEXT_BLKP(next))) == 0);
+}
+
+/*
+ * quick_flush - Free and coalesce every block on the quick lists
+ */
+static void quick_flush(void){
+	size_t c;
+
+	for (c = 0; c < QL_CLASSES; c++){
+		while (quick.head[c] != NULL){
+			char *bp = quick.head[c];
+
+			quick.head[c] = (char *) GET(bp);
+			heap_free(bp);
+		}
+		quick.count[c] = 0;
+	}
+	quick.blocks = 0;
+}
+
+/*
+ * check_quick_lists - Every block on a quick list is an allocated
+ * heap block of the list's size, and the counts add up
+ */
+static int check_quick_lists(void){
+	size_t c, blocks = 0;
+	unsigned n;
+	char *bp;
+
+	for (c = 0; c < QL_CLASSES; c++){
+		n = 0;
+		for (bp = quick.head[c]; bp != NULL; bp = (char *) GET(bp)){
+			if (!in_heap(bp) || !GET_ALLOC(HDRP(bp)) || GET_SIZE(HDRP(bp)) != MIN_BLOCK_SIZE + c * DSIZE){
+				printf("Bad block %p on quick list %lu\n", bp, (unsigned long) c);
+				return 1;
+			}
+			n++;
+		}
+		if (n != quick.count[c]){
+			printf("Quick list %lu holds %u blocks, not %u\n", (unsigned long) c, n, quick.count[c]);
+			return 1;
+		}
+		blocks += n;
+	}
+	if (blocks != quick.blocks){
+		printf("The quick lists hold %lu blocks, not %lu\n", (unsigned long) blocks, (unsigned long) quick.blocks);
+		return 1;
+	}
+	return 0;
+}
+#endif
+
+#ifdef MM_PROFILE
+/*
+ * Sampling heap profiler (-DMM_PROFILE)
+ * -------------------------------------
+ * Every allocation counts its bytes down from a random countdown drawn
+ * from an exponential distribution with mean prof_rate, and the one that
+ * takes it below zero is sampled: its backtrace goes into a hash table
+ * keyed by the block's address, and a new countdown is drawn. So each
+ * byte allocated is sampled with the same small probability (a Poisson
+ * process over the bytes), and a block of size bytes is sampled with
+ * probability 1 - exp(-size / prof_rate), which pprof undoes from the
+ * rate in the profile. Freeing a block drops its sample; a small table
+ * of counters indexed like the samples tells free without a lock that
+ * most blocks have none. Only live samples are kept, so the profile is
+ * of the memory in use when it is written.
+ */
+
+/*
+ * mm_profile_rate - Sample about every bytes bytes allocated, or
+ * nothing at all for 0. Countdowns already running are not redrawn.
+ */
+void mm_profile_rate(size_t bytes){
+	prof_rate = bytes;
+}
+
+/*
+ * prof_next - Bytes until the next sample: -ln(u) * prof_rate for a
+ * uniform u, with log2 of a 26 bit random number taken from its
+ * exponent and a polynomial for its mantissa
+ */
+static long prof_next(void){
+	unsigned long long q;
+	double m, log2q;
+	int e;
+
+	if (prof_rate == 0){
+		return (long) (~0UL >> 1); /*not sampling*/
+	}
+	prof_rng ^= prof_rng >> 12;
+	prof_rng ^= prof_rng << 25;
+	prof_rng ^= prof_rng >> 27;
+	q = ((prof_rng * 0x2545F4914F6CDD1DULL) >> 38) + 1; /*1 to 2^26*/
+	e = 63 - __builtin_clzll(q);
+	m = (double) q / (double) (1ULL << e); /*in [1, 2)*/
+	log2q = e - 1.7417939 + (2.8212026 + (-1.4699568 + (0.44717955 - 0.056570851 * m) * m) * m) * m;
+	return (long) ((26 - log2q) * 0.6931471805599453 * prof_rate) + 1;
+}
+
+/*
+ * prof_sample - The countdown ran out at the block bp of size bytes:
+ * record its backtrace, outside the lock, and draw the next countdown.
+ * A thread's first countdown is drawn here instead of sampling.
+ */
+static void prof_sample(void *bp, size_t size){
+	void *stack[PROF_DEPTH + 1];
+	int depth;
+
+	if (prof_busy){
+		return;
+	}
+	if (prof_rng == 0){ /*first time in this thread*/
+		prof_rng = ((size_t) &prof_rng ^ (size_t) bp) * 0x9E3779B97F4A7C15ULL | 1;
+		prof_countdown = prof_next();
+		return;
+	}
+	prof_countdown = prof_next();
+	if (bp == NULL){
+		return;
+	}
+	prof_busy = 1; /*backtrace may load a library and malloc the first time*/
+	depth = backtrace(stack, PROF_DEPTH + 1) - 1; /*not this frame*/
+	prof_busy = 0;
+	prof_insert(bp, size, stack + 1, MAX(depth, 0));
+}
+
+/*
+ * prof_insert - Record the sample of the block bp of size bytes with
+ * its stack of depth frames, unless the table is full. A block sampled
+ * again keeps its slot.
+ */
+static void prof_insert(void *bp, size_t size, void **stack, int depth){
+	size_t i, mask = PROF_SLOTS - 1;
+	unsigned char *filter;
+	void *table;
+
+#ifdef MM_THREADS
+	pthread_mutex_lock(&prof_lock);
+#endif
+	if (prof_table == NULL){
+		table = mmap(NULL, PROF_SLOTS * sizeof(prof_entry), PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		prof_table = table == MAP_FAILED ? NULL : table;
+	}
+	filter = &prof_filter[PROF_HASH(bp) & (PROF_FILTER_SIZE - 1)];
+	if (prof_table != NULL && prof_count < PROF_MAX && *filter < 255){
+		for (i = PROF_HASH(bp) & mask; prof_table[i].addr != NULL && prof_table[i].addr != bp; i = (i + 1) & mask)
+			;
+		if (prof_table[i].addr == NULL){
+			prof_count++;
+			__atomic_store_n(filter, *filter + 1, __ATOMIC_RELAXED);
+		}
+		prof_table[i].addr = bp;
+		prof_table[i].size = size;
+		prof_table[i].depth = depth;
+		memcpy(prof_table[i].stack, stack, depth * sizeof(void *));
+	}
+#ifdef MM_THREADS
+	pthread_mutex_unlock(&prof_lock);
+#endif
+}
+
+/*
+ * prof_forget - Drop the sample of the block bp being freed, if there
+ * is one, and copy it to out unless that is NULL. The entries after it
+ * in its run move back into the hole, those that may (linear probing
+ * with backward shift deletion). Returns whether bp had a sample.
+ */
+static int prof_forget(void *bp, prof_entry *out){
+	size_t i, j, home, mask = PROF_SLOTS - 1;
+	unsigned char *filter;
+	int found = 0;
+
+	if (bp == NULL || prof_busy){
+		return 0; /*the backtrace frees only what it allocated, unsampled*/
+	}
+#ifdef MM_THREADS
+	pthread_mutex_lock(&prof_lock);
+#endif
+	if (prof_table == NULL){
+		goto out;
+	}
+	for (i = PROF_HASH(bp) & mask; prof_table[i].addr != bp; i = (i + 1) & mask){
+		if (prof_table[i].addr == NULL){
+			goto out; /*a block sharing a filter slot with a sampled one*/
+		}
+	}
+	if (out != NULL){
+		*out = prof_table[i];
+	}
+	found = 1;
+	filter = &prof_filter[PROF_HASH(bp) & (PROF_FILTER_SIZE - 1)];
+	__atomic_store_n(filter, *filter - 1, __ATOMIC_RELAXED);
+	prof_count--;
+	for (j = (i + 1) & mask; prof_table[j].addr != NULL; j = (j + 1) & mask){
+		home = PROF_HASH(prof_table[j].addr) & mask;
+		if (((j - home) & mask) >= ((j - i) & mask)){ /*home is at or before the hole*/
+			prof_table[i] = prof_table[j];
+			i = j;
+		}
 	}
-	place(bp, asize);           /* Place the block */
-	return bp;
+	prof_table[i].addr = NULL;
+out:
+#ifdef MM_THREADS
+	pthread_mutex_unlock(&prof_lock);
+#endif
+	return found;
 }
 
 /*
- *  free - This function frees the block pointed to by bp
- *  and adds this block to the proper segreagated list of free blocks
+ * prof_write - Write all len bytes of buf to fd
  */
-void free(void *bp){
-	size_t size; /*size of block pointed to by bp*/
-	char *header_next; /*pointer to header of next block*/
+static int prof_write(int fd, const char *buf, size_t len){
+	ssize_t n;
 
-	if (bp == NULL){
-		return;
+	while (len > 0){
+		if ((n = write(fd, buf, len)) < 0){
+			if (errno == EINTR){
+				continue;
+			}
+			return -1;
+		}
+		buf += n;
+		len -= n;
 	}
-	header_next = HDRP(NEXT_BLKP(bp)); /*pointer to next block*/
-	size = GET_SIZE(HDRP(bp)); /*get size of this block*/
-	PUT_4(header_next, (GET_SIZE(header_next) | 0 | GET_ALLOC(header_next))); /*update previous blk allocated bit to 0, for next block*/
-
-	PUT_4(HDRP(bp), (size | GET_PREV_ALLOC(HDRP(bp)) | 0));/*Set allocated bit to 0, and retain everything else, for header*/
-	PUT_4(FTRP(bp), GET_4(HDRP(bp))); /*Footer is a replica of header*/
-
-	add_free_blk(bp, size); /*Add this block to the correct seg list*/
-	coalesce(bp); /*coalesce if possible*/
+	return 0;
 }
 
 /*
- *  realloc - Reallocates memory according to specific size
- *  Change the size of the block by mallocing a new block and
- *  freeing the old one
+ * mm_profile_dump - Write the live samples to the file path as a heap
+ * profile in the legacy text format pprof reads (heap_v2): a line per
+ * sample with its bytes and stack, then the mappings of the process to
+ * symbolize the stacks with. Nothing is allocated, so this may be
+ * called at any time. Returns 0, or -1 if the file could not be written.
  */
-void *realloc(void *oldptr, size_t size){
-
-        size_t oldsize; /* Hold the size of the block pointed to by oldptr  */
-        char *newptr;   /* Points to the newly alllocated block */
-
-        if(size == 0){ /*If a size of 0 has to be allocated, just free the oldptr*/
-                free(oldptr);
-                return NULL;
-        }
+int mm_profile_dump(const char *path){
+	char line[64 + PROF_DEPTH * 20];
+	size_t i, objs = 0, bytes = 0;
+	int fd, maps, len, d, err = 0;
+	ssize_t n;
 
-        /*If oldptr is NULL, call a simple malloc for size then*/
-        if(oldptr == NULL){
-                return malloc(size);
-        }
-        /* Calculate payload bytes contained in oldptr */
-        oldsize = GET_SIZE(HDRP(oldptr)) - OVERHEAD;
-        /* If requested size is smaller than old one, old ptr will suffice, so return */
-        if(size <= oldsize){
-                return oldptr;
-        }
-        /* Otherwise, allocated a fresh new block, copy previous bytes and delete the oldptr Need more memory */
-        newptr = (char *) malloc(size);
-        if(!newptr){
-                return NULL;
-        }
-        memcpy(newptr, oldptr, size);
-        free(oldptr);
-        return newptr;
+	if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0){
+		return -1;
+	}
+#ifdef MM_THREADS
+	pthread_mutex_lock(&prof_lock);
+#endif
+	for (i = 0; prof_table != NULL && i < PROF_SLOTS; i++){
+		if (prof_table[i].addr != NULL){
+			objs++;
+			bytes += prof_table[i].size;
+		}
+	}
+	len = snprintf(line, sizeof(line), "heap profile: %lu: %lu [%lu: %lu] @ heap_v2/%lu\n",
+		(unsigned long) objs, (unsigned long) bytes, (unsigned long) objs,
+		(unsigned long) bytes, (unsigned long) prof_rate);
+	err |= prof_write(fd, line, len);
+	for (i = 0; prof_table != NULL && i < PROF_SLOTS; i++){
+		if (prof_table[i].addr == NULL){
+			continue;
+		}
+		len = snprintf(line, sizeof(line), "1: %lu [1: %lu] @", (unsigned long) prof_table[i].size,
+			(unsigned long) prof_table[i].size);
+		for (d = 0; d < prof_table[i].depth; d++){
+			len += snprintf(line + len, sizeof(line) - len, " %p", prof_table[i].stack[d]);
+		}
+		line[len++] = '\n';
+		err |= prof_write(fd, line, len);
+	}
+#ifdef MM_THREADS
+	pthread_mutex_unlock(&prof_lock);
+#endif
+	err |= prof_write(fd, "\nMAPPED_LIBRARIES:\n", 19);
+	if ((maps = open("/proc/self/maps", O_RDONLY)) >= 0){
+		while ((n = read(maps, line, sizeof(line))) > 0){
+			err |= prof_write(fd, line, n);
+		}
+		close(maps);
+	}
+	err |= close(fd);
+	return err ? -1 : 0;
 }
 
 /*
- * calloc - Allocates memory for an array of nmemb elements
- * of size bytes each and returns a pointer to the allocated
- * memory. The memory is set to zero before returning.
+ * check_profile - Every sample is of an allocated block (or a mapping),
+ * and the filter counts the samples right
  */
-void *calloc(size_t nmemb, size_t size){
-	char *ptr, *temp;
-        size_t total_size, i;
+static int check_profile(void){
+	unsigned char filter[PROF_FILTER_SIZE];
+	size_t i, n = 0;
+	int err = 0;
+
+#ifdef MM_THREADS
+	pthread_mutex_lock(&prof_lock);
+#endif
+	memset(filter, 0, sizeof(filter));
+	for (i = 0; prof_table != NULL && i < PROF_SLOTS; i++){
+		char *bp = prof_table[i].addr;
 
-        total_size = (nmemb * size); /*Total size needed to be allocated*/
-        ptr = malloc(total_size); /*Call malloc() to allocate space and get the pointer to first byte*/
-	temp = ptr;
-        /* After the allcattion, initialize each byte to zero, similar to abzero function */
-	for (i = 0; i < nmemb; i++){
-		*temp = 0;
-		temp = (temp + size);
+		if (bp == NULL){
+			continue;
+		}
+		n++;
+		filter[PROF_HASH(bp) & (PROF_FILTER_SIZE - 1)]++;
+		if (in_heap(bp) && !GET_ALLOC(HDRP(bp))){
+			printf("Error: sampled block %p is free\n", bp);
+			err = 1;
+		}
 	}
-	return ptr;
+	if (n != prof_count || memcmp(filter, prof_filter, sizeof(filter)) != 0){
+		printf("Error: %lu samples in the table, %lu counted\n", (unsigned long) n, (unsigned long) prof_count);
+		err = 1;
+	}
+#ifdef MM_THREADS
+	pthread_mutex_unlock(&prof_lock);
+#endif
+	return err;
 }
+#endif
 
 /*
  * mm_checkheap - This function tests the heap consistency
@@ -353,6 +2170,24 @@ void *calloc(size_t nmemb, size_t size){
  * Return 0 for no errors and 1 for an error
  */
 int mm_checkheap(int verbose){
+#ifdef MM_THREADS
+	int ret;
+
+	pthread_mutex_lock(&heap_lock);
+	ret = heap_checkheap(verbose);
+	pthread_mutex_unlock(&heap_lock);
+	return ret;
+#else
+	return heap_checkheap(verbose);
+#endif
+}
+
+/*
+ * heap_checkheap - The checks of mm_checkheap, with the heap locked
+ * in the thread safe build. Blocks in thread caches and on quick lists
+ * count as allocated.
+ */
+static int heap_checkheap(int verbose){
         char *blk; /*pointer to first block in heap*/
 
         if (verbose){
@@ -371,7 +2206,7 @@ int mm_checkheap(int verbose){
                 return 1;
         }
         /*Traverse through blocks in heap*/
-        blk = (NO_OF_LISTS * DSIZE) + (2 * DSIZE) + (heap_ptr);/*pointer to first block in heap*/
+        blk = NEXT_BLKP(heap_start);/*pointer to first block in heap*/
 	if (!GET_ALLOC(HDRP(blk))){ /*if blk points to a free block*/
                 if(check_free_blk(blk)) /*check the free block against the aforementioned criteria and if erro, return 1*/
                         return 1;
@@ -387,6 +2222,8 @@ int mm_checkheap(int verbose){
                         if(check_alloc_blk(blk)) /*check allocated block against aforementioned conditions*/
                                 return 1;
                 }
+                if(check_local(blk)) /*and against its neighbours*/
+                        return 1;
                if(verbose){ /*if verbose is set, print out the details*/
                         if(!GET_ALLOC(HDRP(blk))) /*if free blk, print info of the block*/
                                 print_free_blk(blk);
@@ -408,296 +2245,383 @@ int mm_checkheap(int verbose){
                 return 1;
         if(check_free_blk_count()) /*check number of free block counts by traversing blockwise and pointer wise*/
                 return 1;
+        if(check_stats()) /*the counters of mm_stats agree with the heap*/
+                return 1;
+#ifdef MM_QUICK
+        if(check_quick_lists()) /*blocks on the quick lists count as allocated above*/
+                return 1;
+#endif
+#ifdef MM_PROFILE
+        if(check_profile()) /*every sample is of a live block*/
+                return 1;
+#endif
         return 0; /*return 0, if no error*/
 
 }
 
 
+#ifdef MM_SLAB
+/*
+ * Slab layer (-DMM_SLAB)
+ * ----------------------
+ * Small requests are rounded up to a multiple of 8 and served from a
+ * slab of that slot size. A slab is a page aligned block of the heap
+ * starting with a slab_t header; its slots carry no header at all, so
+ * an 8 byte object costs 8 bytes instead of a 24 byte block. Slabs with
+ * free slots are on a doubly linked list per class; full slabs are on
+ * no list and rejoin it when one of their slots is freed. A slab whose
+ * slots are all free goes back to the heap, unless it is the only
+ * slab left on its list.
+ */
+
+/*
+ * is_slab_ptr - Whether p points into a slab, from the page map
+ */
+static int is_slab_ptr(const void *p){
+	size_t page;
+
+	if (p == NULL || !in_heap(p)){
+		return 0;
+	}
+	page = SLAB_PAGE(p);
+	return (slab_map[page / 64] >> (page % 64)) & 1;
+}
+
+/*
+ * slab_new - Carve a new slab for class c out of the heap and put it
+ * on the list of its class
+ */
+static slab_t *slab_new(size_t c){
+	slab_t *slab;
+	size_t i, page;
+
+	if ((slab = alloc_aligned(SLAB_SIZE, SLAB_SIZE)) == NULL){
+		return NULL;
+	}
+	slab->cls = c;
+	slab->slot_size = (c + 1) * DSIZE;
+	slab->nslots = (SLAB_USABLE - SLAB_SLOTS_OFFSET) / slab->slot_size;
+	slab->nfree = slab->nslots;
+	memset(slab->free_map, 0, sizeof(slab->free_map));
+	for (i = 0; i < slab->nslots; i++){ /*all slots free*/
+		slab->free_map[i / 64] |= (size_t) 1 << (i % 64);
+	}
+	slab->prev = NULL;
+	slab->next = (slab_t *) GET(SLAB_HEAD(c));
+	if (slab->next != NULL){
+		slab->next->prev = slab;
+	}
+	PUT(SLAB_HEAD(c), (size_t) slab);
+	page = SLAB_PAGE(slab);
+	slab_map[page / 64] |= (size_t) 1 << (page % 64);
+	return slab;
+}
+
+/*
+ * slab_malloc - Take the first free slot of the first slab with free
+ * slots of the class of size, making a new slab if there is none
+ */
+static void *slab_malloc(size_t size){
+	size_t c = SLAB_CLASS(size);
+	slab_t *slab = (slab_t *) GET(SLAB_HEAD(c));
+	size_t w, i;
+
+	if (slab == NULL && (slab = slab_new(c)) == NULL){
+		return NULL;
+	}
+	for (w = 0; slab->free_map[w] == 0; w++)
+		; /*the slab has a free slot, so this stops*/
+	i = __builtin_ctzl(slab->free_map[w]);
+	slab->free_map[w] &= ~((size_t) 1 << i);
+	if (--slab->nfree == 0){ /*full, take it off the list*/
+		PUT(SLAB_HEAD(c), (size_t) slab->next);
+		if (slab->next != NULL){
+			slab->next->prev = NULL;
+		}
+	}
+	return (char *) slab + SLAB_SLOTS_OFFSET + (w * 64 + i) * slab->slot_size;
+}
+
+/*
+ * slab_free - Mark the slot of p free, and give the slab back to
+ * the heap if that leaves it empty
+ */
+static void slab_free(void *p){
+	slab_t *slab = SLAB_OF(p);
+	size_t i = ((char *) p - ((char *) slab + SLAB_SLOTS_OFFSET)) / slab->slot_size;
+	size_t page;
+
+	slab->free_map[i / 64] |= (size_t) 1 << (i % 64);
+	if (slab->nfree++ == 0){ /*was full, back on the list*/
+		slab->prev = NULL;
+		slab->next = (slab_t *) GET(SLAB_HEAD(slab->cls));
+		if (slab->next != NULL){
+			slab->next->prev = slab;
+		}
+		PUT(SLAB_HEAD(slab->cls), (size_t) slab);
+	}
+	if (slab->nfree == slab->nslots && (slab->prev != NULL || slab->next != NULL)){
+		if (slab->prev != NULL){ /*empty and not the last slab of its class*/
+			slab->prev->next = slab->next;
+		}
+		else{
+			PUT(SLAB_HEAD(slab->cls), (size_t) slab->next);
+		}
+		if (slab->next != NULL){
+			slab->next->prev = slab->prev;
+		}
+		page = SLAB_PAGE(slab);
+		slab_map[page / 64] &= ~((size_t) 1 << (page % 64));
+		heap_free(slab);
+	}
+}
+
+/*
+ * slab_realloc - realloc where the old block or the new size is a
+ * slab slot. The slot is kept if the new size still fits in it.
+ */
+static void *slab_realloc(void *oldptr, size_t size){
+	size_t oldsize;
+	char *newptr;
+
+	if (oldptr == NULL){
+		return front_malloc(size);
+	}
+	if (size == 0){
+		slab_free(oldptr);
+		return NULL;
+	}
+	oldsize = SLAB_OF(oldptr)->slot_size;
+	if (size <= oldsize){
+		return oldptr;
+	}
+	if ((newptr = front_malloc(size)) == NULL){
+		return NULL;
+	}
+	memcpy(newptr, oldptr, oldsize);
+	slab_free(oldptr);
+	return newptr;
+}
+#endif
+
 /*Helper functions*/
 
 /*
- * extend_heap - Thsi function extends the heap by words no of bytes
- * and adds the block to the correct seg list, coalesces it 
- * and returns a pointer to it
+ * extend_heap - Extend the heap by words bytes, with -DMM_HUGE up to the
+ * next huge page boundary, as a free block on its list merged with a free
+ * last block (block_extend), and return it, or NULL if words is more than
+ * INT_MAX
  */
 static void *extend_heap(size_t words){
-	char *bp; /*pointer to the extended block*/
+	char *bp; /*the new space, the header of the extended block is the old epilogue*/
+	char *merged; /*the block after coalescing*/
+#ifdef MM_HUGE
+	char *first = (char *) (((size_t) mem_heap_hi() + 1) & ~(MEM_HUGE_PAGE - 1)); /*huge page the extension starts in*/
+#endif
 
-	if ((long) (bp = mem_sbrk(words)) < 0){
+	bp = (char *) mem_heap_hi() + 1;
+#ifdef MM_HUGE
+	/*up to the next huge page boundary, and ask for the new huge pages to be huge*/
+	words = (((size_t) bp + words + MEM_HUGE_PAGE - 1) & ~(MEM_HUGE_PAGE - 1)) - (size_t) bp;
+#endif
+	if ((merged = block_extend(words)) == NULL){
 		return NULL;
 	}
-	PUT_4(HDRP(bp), PACK(words,(0 | GET_PREV_ALLOC(HDRP(bp))) | 0)); /*Set header	bits to retainf prev allocated status*/
-	PUT_4(FTRP(bp), GET_4(HDRP(bp))); /*Footer is a replica of header*/
-	PUT_4(HDRP(NEXT_BLKP(bp)), PACK(0, 1)); /*New epilogue block*/
-	add_free_blk(bp, words); /*Add it to the corect segregated list*/
-	return coalesce(bp); /*coalesce if possible and return a block pointer*/
-}
-
-/*
- * coalesce- This function combines adjacent free blocks
- * to form a larger free block and minimize external fragmentation
- */
-static void *coalesce(void *bp){
-	size_t size = GET_SIZE(HDRP(bp)); /*size of current block*/
-	int check;
-	char *prev_blk = PREV_BLKP(bp);
-	char *prev_hdr = HDRP(prev_blk);
-	size_t prev_size;
-	char *next_blk = NEXT_BLKP(bp);
-	size_t next_size = GET_SIZE(HDRP(next_blk));
-	size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));/*next block allocated */
-	size_t prev_alloc = GET_PREV_ALLOC(HDRP(bp)); /*previous block allocated*/
-	check = (prev_alloc | next_alloc);
-
-	switch(check){
-	case 3:
-		/*If both next and prev blocks are allocated return */
-		break;
-	case 2:
-		/*If prev block is allocated and next is free */
-		rem_free_blk(bp, size); /*remove both the blocks from free list*/
-		rem_free_blk(next_blk, next_size);
-		size += next_size; /*update the size*/
-		PUT_4(HDRP(bp), PACK(size, prev_alloc));/*update the header and footer with new size and prev blk allocated*/
-		PUT_4(FTRP(bp), PACK(size, prev_alloc));
-		add_free_blk(bp, size);/*add this new blk to free list*/
-		break;
-	case 1:
-		/*prev blok is allocated and next is free*/
-		prev_size = GET_SIZE(prev_hdr);
-		rem_free_blk(bp, size);/*remove prev blk and current blk from apt free list*/
-		rem_free_blk(prev_blk, prev_size);
-		size += prev_size;/*update size*/
-		PUT_4(prev_hdr, PACK(size, GET_PREV_ALLOC(prev_hdr)));/*update header and footer of the free blk*/
-		PUT_4(FTRP(prev_blk), GET_4(prev_hdr));
-		add_free_blk(prev_blk, size);/*add it to the apt free list*/
-		bp = prev_blk;/*point to prev blk*/
-		break;
-	case 0:
-		/*Previous block is free and next block is free*/
-		prev_size = GET_SIZE(prev_hdr);
-		rem_free_blk(bp, size);/*remove prev, current and next free blks from the apt lists*/
-        	rem_free_blk(prev_blk, prev_size);
-        	rem_free_blk(next_blk, next_size);
-		size += prev_size + next_size; /*update size*/
-		PUT_4(prev_hdr, PACK(size, GET_PREV_ALLOC(prev_hdr)));
-		PUT_4(FTRP(prev_blk), GET_4(prev_hdr));
-		add_free_blk(prev_blk, size);/*add to apt list*/
-		bp = prev_blk; /*point to prev blk*/
-	}
-	return bp; /*return pointer to the new free blk*/
-}
-
-/*
- * place - This function places the block pointed to by bp , in a block of size asize
- * if the remaining size is >= minimum block size, we split and allocate the first half
- * the second half is added to the free list as another free block
- * if not 
- * allocate the whole block
+#ifdef MM_HUGE
+	mem_hugepage(first, bp + words - first);
+#endif
+	if (merged != bp){
+		/*clear the old footer, header and links inside the merged block, for calloc*/
+		memset(bp - DSIZE, 0, DSIZE + 2 * LINK_SIZE);
+	}
+	return merged;
+}
+
+/*
+ * place - Allocate asize bytes at the start of the free block bp and
+ * split the rest off as a free block if it is big enough (block_place)
  */
 static void place(void *bp, size_t asize){
+	block_place(bp, asize);
+	heap_fresh = MAX(heap_fresh, NEXT_BLKP(bp)); /*the block may be handed out now*/
+}
+
+#ifdef MM_HUGE
+/*
+ * place_high - Allocate asize bytes at the top of the free block bp and
+ * leave the bottom on the lists, if it is big enough to be a block and bp
+ * is not the last block, which should stay free for the heap to grow into.
+ * Returns the allocated block.
+ */
+static char *place_high(char *bp, size_t asize){
+	size_t blk_size = GET_SIZE(HDRP(bp));
+	size_t extra = blk_size - asize; /*bytes left at the bottom*/
+	char *high, *next_blk;
+
+	if (extra < MIN_BLOCK_SIZE || GET_SIZE(HDRP(NEXT_BLKP(bp))) == 0){
+		place(bp, asize);
+		return bp;
+	}
+	block_rem_free(bp, blk_size);
+	block_set_free(bp, extra);
+	block_add_free(bp, extra);
+	high = NEXT_BLKP(bp);
+	PUT_4(HDRP(high), PACK(asize, ALLOC)); /*the block before it is free*/
+	next_blk = NEXT_BLKP(high); /*allocated, free blocks do not touch*/
+	PUT_4(HDRP(next_blk), GET_4(HDRP(next_blk)) | PREV_ALLOC);
+	heap_stats.splits++;
+	heap_fresh = MAX(heap_fresh, next_blk); /*the block may be handed out now*/
+	return high;
+}
+#endif
 
-	size_t blk_size = GET_SIZE(HDRP(bp));/*size of current block*/
-	size_t extra = blk_size - asize; /*remaining number of bytes*/
-	char *next_blk = NEXT_BLKP(bp); /*next block pointer*/
+/*
+ * carve - Allocate n blocks of asize bytes back to back from the
+ * start of the free block bp, which holds at least n * asize bytes,
+ * and store them in out. The rest goes back to the lists, or to the
+ * last block if it is too small to be a block of its own.
+ */
+static size_t carve(char *bp, size_t asize, size_t n, void **out){
+	size_t blk_size = GET_SIZE(HDRP(bp));
+	size_t extra = blk_size - n * asize; /*bytes left after the n blocks*/
+	char *next_blk;
+	size_t i;
 
-	/* Remove this block from free list and check for splitting */
-	rem_free_blk(bp, blk_size);
-	if (extra >= MIN_BLOCK_SIZE) {
-		PUT_4(HDRP(bp), PACK(asize, GET_PREV_ALLOC(HDRP(bp)) | ALLOC)); /*allocate for previosu block*/
-		next_blk = NEXT_BLKP(bp);
-		PUT_4(HDRP(next_blk), extra | PREV_ALLOC);/*update header and footer of next block, as next is free*/
-        	PUT_4(FTRP(next_blk), extra | PREV_ALLOC);
-		add_free_blk(next_blk, extra);/*add next free block to free list*/
+	block_rem_free(bp, blk_size);
+	PUT_4(HDRP(bp), PACK(asize, GET_PREV_ALLOC(HDRP(bp)) | ALLOC));
+	out[0] = bp;
+	for (i = 1; i < n; i++){
+		bp += asize;
+		PUT_4(HDRP(bp), PACK(asize, PREV_ALLOC | ALLOC));
+		out[i] = bp;
+	}
+	if (extra >= MIN_BLOCK_SIZE){
+		next_blk = bp + asize;
+		PUT_4(HDRP(next_blk), PREV_ALLOC);
+		block_set_free(next_blk, extra);
+		block_add_free(next_blk, extra);
+		heap_stats.splits++;
 	}
 	else {
-	        PUT_4(HDRP(bp), PACK(blk_size, GET_PREV_ALLOC(HDRP(bp)) | ALLOC));/*allocate the whole block*/
-		PUT_4(HDRP(next_blk), GET_4(HDRP(next_blk)) | PREV_ALLOC);/*update header of next block*/
-		if (!GET_ALLOC(HDRP(next_blk))){ /*if next bloxk is free, it has a footer also, update*/
-			PUT_4(FTRP(next_blk), GET_4(HDRP(next_blk)));
-		}
+		block_set_alloc(bp, asize + extra); /*the last block takes the rest*/
 	}
+	heap_fresh = MAX(heap_fresh, NEXT_BLKP(bp)); /*the blocks may be handed out now*/
+	return n;
 }
 
+#ifndef TLSF
 /*
- * find_fit - this function first  finds a list and then
- * calls find_block_in_list to find the exact block
- * in which the given block of asize will fit into
+ * find_fit - First fit in the segregated lists (block_find_fit)
  */
 static void *find_fit(size_t asize){
-	size_t index; /*stores the index of the appropriate list*/
-	size_t i;
-	char *bp = NULL;/*stores the ptr to the free block*/
-	index = get_index(asize);
-	for(i = index; i < NO_OF_LISTS; i++){ /*find the block in the list, or a list that has size >= asize*/
-		 if ((bp = find_block_in_list(i, asize)) != NULL)
-                return bp;
-        }
-	return bp; /*if not found, return NULL*/
+	return block_find_fit(asize);
 }
 
 /*
- * get_index - Given the size of a block, return the index of the 
- * segregated list it will fit into
+ * get_index - The segregated list of a block of asize bytes (seg_index)
  */
 static size_t get_index(size_t asize){
-	if(asize <= LIST0_SIZE)
-		return 0;
-	else if(asize <= LIST1_SIZE)
-		return 1;
-	else if(asize <= LIST2_SIZE)
-		return 2;
-	else if(asize <= LIST3_SIZE)
-		return 3;
-	else if(asize <= LIST4_SIZE)
-		return 4;
-	else if(asize <= LIST5_SIZE)
-		return 5;
-	else if(asize <= LIST6_SIZE)
-		return 6;
-	else if(asize <= LIST7_SIZE)
-		return 7;
-	else if(asize <= LIST8_SIZE)
-		return 8;
-	else if(asize <= LIST9_SIZE)
-		return 9;
-	else if(asize <= LIST10_SIZE)
-		return 10;
-	else
-		return 11;
-}
-
-/*
- * find_block_in_list - given the index of a list and required size to be allocated 
- * this function finds the block that can fit the required size of block in it
- */
-static void *find_block_in_list(size_t index, size_t size){
-	char *fit_blk = NULL; /*get the block*/
-	size_t fit_list; /*the list this index represents*/
-	fit_list = find_list(index); 
-	fit_blk = (char *) GET(heap_ptr + fit_list);
-	while (fit_blk != NULL) { /*find the right block in the list that fits*/
-	        if (size <= GET_SIZE(HDRP(fit_blk))) {
-	            break;
-        }
-        	fit_blk = (char *) GET(NEXT_FREE(fit_blk));
-	}
-
-	return fit_blk;
-}
-
-/*
- * find_list - Given the index of a list, return back 
- * the list it represenst and offset to that list
- */
-static size_t find_list(size_t ind){
-	if(ind == 0)
-		return LIST_0;
-	else if(ind == 1)
-		return LIST_1;
-	else if(ind == 2)
-		return LIST_2;
-	else if(ind == 3)
-		return LIST_3;
-	else if(ind == 4)
-		return LIST_4;
-	else if(ind == 5)
-		return LIST_5;
-	else if(ind == 6)
-		return LIST_6;
-	else if(ind == 7)
-		return LIST_7;
-	else if(ind == 8)
-		return LIST_8;
-	else if(ind == 9)
-		return LIST_9;
-	else if(ind == 10)
-		return LIST_10;
-	else
-		return LIST_11;
-}
-
-/*
- * find_list_by_size - given the size of a block, 
- * find the list it belongs to and return the list's offset
- */
-static size_t find_list_by_size(size_t ind){
-	if(ind <= LIST0_SIZE)
-		return LIST_0;
-	else if (ind <= LIST1_SIZE)
-		return LIST_1;
-	else if(ind <= LIST2_SIZE)
-		return LIST_2;
-	else if(ind <= LIST3_SIZE)
-		return LIST_3;
-	else if(ind <= LIST4_SIZE)
-		return LIST_4;
-	else if(ind <= LIST5_SIZE)
-		return LIST_5;
-	else if(ind <= LIST6_SIZE)
-		return LIST_6;
-	else if(ind <= LIST7_SIZE)
-		return LIST_7;
-	else if(ind <= LIST8_SIZE)
-		return LIST_8;
-	else if(ind <= LIST9_SIZE)
-		return LIST_9;
-	else if(ind <= LIST10_SIZE)
-		return LIST_10;
-	else
-		return LIST_11;
-}
-
-/*
- * add_free_blk - This function add a free block, pointed to by bp
- * , of size 'size', and place it in the correct segregated list
- */
-static void add_free_blk(char *bp, size_t size){
-	size_t list_num = 0;/*the list number can be added to*/  
-	char *fit_blk = NULL;/*head of list*/
-	char *fit_seg;
-	list_num = find_list_by_size(size); /*index to list*/
-	fit_seg = heap_ptr + list_num; /*get the index to the list*/
-	fit_blk = (char *) GET(heap_ptr + list_num);/*get the head of list*/
-	if (fit_blk != NULL){ /*If there are free blocks in the list, add this blk at the head*/
-		PUT(fit_seg, (size_t) bp);
-		PUT(PREV_FREE(bp), (size_t) NULL);/*set prev pointer to NULL*/
-		PUT(PREV_FREE(fit_blk), (size_t) bp); /*add it at the head of the list*/
-		PUT(NEXT_FREE(bp), (size_t) fit_blk);
-	}
-	else {/*else this is the only block in the seg list*/
-		PUT(fit_seg, (size_t) bp); /*make bp the head of the list*/
-		PUT(PREV_FREE(bp), (size_t) NULL);
-		PUT(NEXT_FREE(bp), (size_t) NULL);
-	}
-}
-
-/*
- * rem_free_blk - remove the block pointed to by bp, of size 'size'
- * from the correct segregated list, and adjust the pointers accordingly
- */
-static void rem_free_blk(char *bp, size_t size){
-	size_t list_num = 0; /*the list number block belongs to*/
-	char *next_free_blk = (char *) GET(NEXT_FREE(bp)); /*the next free blk , bp points to*/
-	char *prev_free_blk = (char *) GET(PREV_FREE(bp));/*the previous free block*/
-
-	list_num = find_list_by_size(size); /*Get the header location of the relevant list, the block belongs to*/
-	if (prev_free_blk == NULL && next_free_blk == NULL) {/*if this is the only block in the list*/
-                PUT(heap_ptr + list_num, (size_t) NULL); /*the head is NULL now*/
-        }
-	else if (prev_free_blk == NULL && next_free_blk != NULL) { /*If this the first block pointed to by head of list*/
-		PUT(heap_ptr + list_num, (size_t) next_free_blk);/*make the next block the head of the list*/
-		PUT(PREV_FREE(next_free_blk), (size_t) NULL);/*set its previosu to NULL*/
+	return seg_index(asize);
+}
+
+/*
+ * mark_list, unmark_list, list_marked - Set, clear and test
+ * the bit of list index in the bitmap of non-empty lists
+ */
+static void mark_list(size_t index){
+	PUT(SEG_BITMAP, GET(SEG_BITMAP) | ((size_t) 1 << index));
+}
+
+static void unmark_list(size_t index){
+	PUT(SEG_BITMAP, GET(SEG_BITMAP) & ~((size_t) 1 << index));
+}
+
+static int list_marked(size_t index){
+	return (GET(SEG_BITMAP) >> index) & 1;
+}
+
+#else
+/*
+ * find_fit - Good fit search of the two level index. asize is rounded
+ * up to the next list boundary, so every block of that list or of any
+ * later non-empty list fits, and the list is found with one ctz on the
+ * second level bitmap or, failing that, one ctz on the first level bitmap
+ * and one on the second. Only if nothing is left above do we look for a
+ * block in the list asize itself falls in, before growing the heap,
+ * except with -DMM_RT.
+ */
+static void *find_fit(size_t asize){
+	size_t index; /*list asize would be inserted in*/
+	size_t fl, sl; /*first and second level of the search*/
+	size_t rounded = asize; /*asize rounded up to the next list boundary*/
+	unsigned sl_map; /*non-empty second level lists at or above sl*/
+	size_t fl_map; /*non-empty first levels above fl*/
+
+	if (asize >= SMALL_LIMIT){
+		rounded += ((size_t) 1 << (63 - __builtin_clzl(asize) - SL_SHIFT)) - 1;
 	}
-	else if (prev_free_blk != NULL && next_free_blk == NULL) {/*if this is the last block in the list*/
-                PUT(NEXT_FREE(prev_free_blk), (size_t) NULL);/*make the previous block , the last block*/
-        }
-	else { /*if the block is in the middle*/
-		PUT(NEXT_FREE(prev_free_blk), (size_t) next_free_blk);/*make previous block point to next and next to previous*/
-		PUT(PREV_FREE(next_free_blk), (size_t) prev_free_blk);
+	index = get_index(rounded);
+	fl = index / SL_COUNT;
+	sl = index % SL_COUNT;
+	sl_map = GET_4(SL_BITMAP(fl)) & (~0U << sl);
+	if (sl_map == 0){
+		fl_map = GET(FL_BITMAP) & ~(((size_t) 2 << fl) - 1);
+		if (fl_map == 0){ /*no list above can hold asize, try the list asize falls in*/
+#ifdef MM_RT
+			return NULL; /*unless that would be a walk of unbounded length*/
+#else
+			return block_find_in_list(get_index(asize), asize);
+#endif
+		}
+		fl = __builtin_ctzl(fl_map);
+		sl_map = GET_4(SL_BITMAP(fl));
+	}
+	sl = __builtin_ctz(sl_map);
+	return (char *) GET(heap_ptr + LIST_OFFSET(fl * SL_COUNT + sl));
+}
+
+/*
+ * get_index - Given the size of a block, return the index of the
+ * list it is kept in: first level is log2 of the size, second level
+ * the next SL_SHIFT bits below the leading one
+ */
+static size_t get_index(size_t asize){
+	size_t fl, sl, log2;
+
+	if (asize < SMALL_LIMIT){
+		return asize >> 3; /*fl is 0, one list per 8 bytes*/
+	}
+	log2 = 63 - __builtin_clzl(asize);
+	fl = MIN(log2 - FL_SHIFT + 1, FL_COUNT - 1);
+	sl = (asize >> (log2 - SL_SHIFT)) & (SL_COUNT - 1);
+	return fl * SL_COUNT + sl;
+}
+
+/*
+ * mark_list, unmark_list, list_marked - Set, clear and test
+ * the bits of list index in the two level bitmap
+ */
+static void mark_list(size_t index){
+	size_t fl = index / SL_COUNT;
+
+	PUT_4(SL_BITMAP(fl), GET_4(SL_BITMAP(fl)) | (1U << (index % SL_COUNT)));
+	PUT(FL_BITMAP, GET(FL_BITMAP) | ((size_t) 1 << fl));
+}
+
+static void unmark_list(size_t index){
+	size_t fl = index / SL_COUNT;
+
+	PUT_4(SL_BITMAP(fl), GET_4(SL_BITMAP(fl)) & ~(1U << (index % SL_COUNT)));
+	if (GET_4(SL_BITMAP(fl)) == 0){ /*last list of this first level*/
+		PUT(FL_BITMAP, GET(FL_BITMAP) & ~((size_t) 1 << fl));
 	}
 }
 
+static int list_marked(size_t index){
+	return (GET_4(SL_BITMAP(index / SL_COUNT)) >> (index % SL_COUNT)) & 1;
+}
+#endif
+
 /*
  * Return whether the pointer is in the heap.
  * may be useful for debugging.
@@ -714,35 +2638,6 @@ static int aligned(const void *p){
 	return (size_t) (((size_t) (p) + 7) & ~0x7) == (size_t) p;
 }
 
-/*
- * get_list_size - This function takes in an index and returns back 
- * the size of the list that can be indexed by that index
- */
-static size_t get_list_size(size_t index){
-	if(index == 0)
-		return LIST0_SIZE;
-	else if(index == 1)
-		return LIST1_SIZE;
-	else if(index == 2)
-		return LIST2_SIZE;
-	else if(index == 3)
-                return LIST3_SIZE;
-	else if(index == 4)
-                return LIST4_SIZE;
-	else if(index == 5)
-                return LIST5_SIZE;
-	else if(index == 6)
-                return LIST6_SIZE;
-	else if(index == 7)
-                return LIST7_SIZE;
-	else if(index == 8)
-                return LIST8_SIZE;
-	else if(index == 9)
-                return LIST9_SIZE;
-	else
-                return LIST10_SIZE;
-}
-
 /*
  * check_free_blk_count - This function checks if
  * the number of free blocks counted in heap is same as 
@@ -758,16 +2653,15 @@ static int check_free_blk_count(){
 	
 	/*iterate over the free lists by pointers*/
 	for(i =0; i < NO_OF_LISTS; i++){ /*traverse through each list*/
-		list_num = find_list(i);
-		bp = (char *) (heap_ptr + list_num); /*head of the list*/
-		bp = (char *)GET(NEXT_FREE(bp));
+		list_num = LIST_OFFSET(i);
+		bp = (char *) GET(heap_ptr + list_num); /*head of the list*/
 		while(bp != NULL){/*traverse from one block to another by pointer*/
 			cnt_ptr ++;/*count free blocks*/
-			bp = (char *)GET(NEXT_FREE(bp));
+			bp = GET_NEXT_FREE(bp);
 		}
 	}
 	
-	blk = (NO_OF_LISTS * DSIZE) + (2 * DSIZE) + (heap_ptr); /*pointer to first block in heap*/
+	blk = NEXT_BLKP(heap_start); /*pointer to first block in heap*/
 	/*Iterate blockwise*/
 	while((GET_4(HDRP(blk)) != 1) && (GET_4(HDRP(blk)) != 3)){ /*while epilogues block has not been hit*/
 		if(!GET_ALLOC(HDRP(blk))){/*if free, increment count*/
@@ -783,6 +2677,99 @@ static int check_free_blk_count(){
 	return 0;
 }
 
+/*
+ * mm_checkheap_step - Check the next CHECK_SLICE blocks of the heap with
+ * check_local, taking up where the last call stopped, so that checking
+ * after every operation costs O(1) however big the heap. A whole pass
+ * takes a call per CHECK_SLICE blocks; at the end of each the epilogue
+ * and the heads of the lists are checked, and it starts over. Counts and
+ * cycles away from the list heads are left to mm_checkheap.
+ *
+ * Return 0 for no errors and 1 for an error
+ */
+int mm_checkheap_step(int verbose){
+#ifdef MM_THREADS
+	int ret;
+
+	pthread_mutex_lock(&heap_lock);
+	ret = heap_check_step(verbose);
+	pthread_mutex_unlock(&heap_lock);
+	return ret;
+#else
+	return heap_check_step(verbose);
+#endif
+}
+
+/*
+ * heap_check_step - The checks of mm_checkheap_step, with the heap locked
+ * in the thread safe build. The merges and trims that make a block end
+ * or vanish move check_cursor to a block still there (see CHECK_MERGED).
+ */
+static int heap_check_step(int verbose){
+	char *blk = check_cursor != NULL ? check_cursor : NEXT_BLKP(heap_start);
+	int n;
+
+	for (n = 0; n < CHECK_SLICE; n++){
+		if (GET_SIZE(HDRP(blk)) == 0){ /*the epilogue, the pass is over*/
+			if (!GET_ALLOC(HDRP(blk))){
+				printf("Bad epilogue header\n");
+				return 1;
+			}
+			if (check_list_heads()){
+				return 1;
+			}
+			blk = NEXT_BLKP(heap_start);
+			continue;
+		}
+		if (check_local(blk)){
+			return 1;
+		}
+		if (verbose){
+			if (!GET_ALLOC(HDRP(blk)))
+				print_free_blk(blk);
+			else
+				print_alloc_blk(blk);
+		}
+		blk = NEXT_BLKP(blk);
+	}
+	check_cursor = blk;
+	return 0;
+}
+
+/*
+ * check_stats - The free bytes and blocks heap_stats keeps for each size
+ * class match the free blocks found walking the heap, and the heap is
+ * no bigger than its peak
+ */
+static int check_stats(void){
+	size_t bytes[MM_SIZE_CLASSES], blocks[MM_SIZE_CLASSES];
+	size_t i;
+	char *blk;
+
+	memset(bytes, 0, sizeof(bytes));
+	memset(blocks, 0, sizeof(blocks));
+	for (blk = NEXT_BLKP(heap_start); GET_SIZE(HDRP(blk)) != 0; blk = NEXT_BLKP(blk)){
+		if (!GET_ALLOC(HDRP(blk))){
+			bytes[MM_SIZE_CLASS(GET_SIZE(HDRP(blk)))] += GET_SIZE(HDRP(blk));
+			blocks[MM_SIZE_CLASS(GET_SIZE(HDRP(blk)))]++;
+		}
+	}
+	for (i = 0; i < MM_SIZE_CLASSES; i++){
+		if (bytes[i] != heap_stats.class_bytes[i] || blocks[i] != heap_stats.class_blocks[i]){
+			printf("Error: size class %lu has %lu free blocks of %lu bytes, the counters say %lu of %lu\n",
+				(unsigned long) i, (unsigned long) blocks[i], (unsigned long) bytes[i],
+				(unsigned long) heap_stats.class_blocks[i], (unsigned long) heap_stats.class_bytes[i]);
+			return 1;
+		}
+	}
+	if (mem_heapsize() > heap_stats.peak_heap){
+		printf("Error: heap of %lu bytes above its peak of %lu\n",
+			(unsigned long) mem_heapsize(), (unsigned long) heap_stats.peak_heap);
+		return 1;
+	}
+	return 0;
+}
+
 /*
  * check_for_cycle - This function checks if at all
  * there is a cycle in any of the seg lists
@@ -794,17 +2781,13 @@ static int check_for_cycle(){
 	char *tortoise; /*the other iterator of the list*/
  
 	for(i = 0; i < NO_OF_LISTS; i++){ /*iterate through each list*/
-                list_num = find_list(i);
-                hare = (char *) (heap_ptr + list_num);
-                tortoise = (char *) (heap_ptr + list_num);
+                list_num = LIST_OFFSET(i);
+                hare = (char *) GET(heap_ptr + list_num); /*the head is a pointer, not a link*/
+                tortoise = hare;
                 /*check for a cycle in the list  y using hare and tortoise*/
-                while(hare != NULL && tortoise != NULL){
-                        if(hare != NULL){
-                                hare = (char *) GET(NEXT_FREE(hare));
-                        }
-                        if(hare != NULL){
-                                tortoise = (char *)GET(NEXT_FREE(hare));
-                        }
+                while(hare != NULL && GET_NEXT_FREE(hare) != NULL){
+                        tortoise = GET_NEXT_FREE(tortoise);
+                        hare = GET_NEXT_FREE(GET_NEXT_FREE(hare));
                         if(hare == tortoise){ /*A cycle exists in the list*/
                                 printf("Error: There is a cycle in the list\n");
                                 return 1;
@@ -817,37 +2800,105 @@ static int check_for_cycle(){
 /*
  * check_seg_lists - This function checks all the segregated lists
  * to see if there is any block that does not fall within the appropriate 
- * range of the segreagted list
+ * range of the segreagted list, and that the bitmap of non-empty lists
+ * is in sync with the lists
  */
 static int check_seg_lists(){
 	size_t i; /*traverse through the lists*/
-	size_t list_num; /*Hold the offset to the list*/
-	size_t min_size; /*minimum size range of the list*/
-	size_t max_size; /*maximum allowed size in a list*/
 	char *list_p; /*pointer to a block in a list*/
 
 	/* Check if all blocks in each freelist fall within the appropriate range*/
 	for (i = 0; i < NO_OF_LISTS; i++){
-		list_num  =  find_list(i);
-		if(i ==0){
-			min_size = 0;
-                        max_size = LIST0_SIZE;
-		}
-		 else if(i == 11){
-                        min_size = LIST10_SIZE;
-                        max_size = ~0;
-                }
-		else{
-                        min_size = get_list_size(i-1);
-                        max_size = get_list_size(i);
-                }
-		list_p = (char *) GET(heap_ptr + list_num);
+		list_p = (char *) GET(heap_ptr + LIST_OFFSET(i));
+		if ((list_p != NULL) != list_marked(i)){ /*bitmap must agree with the list*/
+			printf("The bitmap bit of list %lu does not match the list\n", (unsigned long) i);
+			return 1;
+		}
 		while (list_p != NULL){
-			if (!(min_size < GET_SIZE(HDRP(list_p)) && GET_SIZE(HDRP(list_p)) <= max_size)){
+			if (get_index(GET_SIZE(HDRP(list_p))) != i){
 				printf("The free blk pointer %p is not in the apt free list", list_p);
 				return 1;
 			}
-			list_p = (char *) GET(NEXT_FREE(list_p));
+			list_p = GET_NEXT_FREE(list_p);
+		}
+	}
+	return 0;
+}
+
+/*
+ * check_local - Check the block blk against its neighbours, in O(1):
+ * its size is sane, the next block's prev allocated bit is right, a free
+ * block before it has matching boundary tags and is not next to another
+ * free block, and a free blk is linked both ways with the blocks next to
+ * it on its list, which is the list of its size, and heads the list if
+ * nothing is before it
+ */
+static int check_local(char *blk){
+	size_t size = GET_SIZE(HDRP(blk));
+	char *next = NEXT_BLKP(blk);
+	char *prev;
+
+	if (blk <= heap_start || (char *) HDRP(blk) > (char *) mem_heap_hi() || !aligned(blk)){
+		printf("Block %p not in heap or not aligned\n", blk);
+		return 1;
+	}
+	if (size < MIN_BLOCK_SIZE || size % DSIZE != 0 || HDRP(next) > (char *) mem_heap_hi()){
+		printf("Block %p has a bad size of %lu\n", blk, (unsigned long) size);
+		return 1;
+	}
+	if (!GET_PREV_ALLOC(HDRP(next)) != !GET_ALLOC(HDRP(blk))){
+		printf("Block %p after %p has a wrong prev allocated bit\n", next, blk);
+		return 1;
+	}
+	if (!GET_PREV_ALLOC(HDRP(blk))){
+		prev = PREV_BLKP(blk);
+		if (prev <= heap_start || GET_4(HDRP(prev)) != GET_4(FTRP(prev)) || GET_ALLOC(HDRP(prev))){
+			printf("Free block %p before %p has bad boundary tags\n", prev, blk);
+			return 1;
+		}
+		if (!GET_ALLOC(HDRP(blk))){
+			printf("Error: Free block pointer %p and %p are adjacent\n", prev, blk);
+			return 1;
+		}
+	}
+	if (GET_ALLOC(HDRP(blk))){
+		return 0;
+	}
+	if (GET_4(HDRP(blk)) != GET_4(FTRP(blk)) || !GET_ALLOC(HDRP(next))){
+		printf("Free block pointer %p: bad footer or a free block after it\n", blk);
+		return 1;
+	}
+	if (GET_NEXT_FREE(blk) != NULL && GET_PREV_FREE(GET_NEXT_FREE(blk)) != blk){
+		printf("Free block pointer %p's next pointer is inconsistent\n", blk);
+		return 1;
+	}
+	prev = GET_PREV_FREE(blk);
+	if (prev == NULL ? (char *) GET(heap_ptr + LIST_OFFSET(get_index(size))) != blk
+	    : GET_NEXT_FREE(prev) != blk || get_index(GET_SIZE(HDRP(prev))) != get_index(size)){
+		printf("The free blk pointer %p is not in the apt free list\n", blk);
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * check_list_heads - Each list head starts its list, is in the list of
+ * its size and agrees with the bitmap of non-empty lists, in O(lists)
+ */
+static int check_list_heads(void){
+	size_t i;
+	char *head;
+
+	for (i = 0; i < NO_OF_LISTS; i++){
+		head = (char *) GET(heap_ptr + LIST_OFFSET(i));
+		if ((head != NULL) != list_marked(i)){
+			printf("The bitmap bit of list %lu does not match the list\n", (unsigned long) i);
+			return 1;
+		}
+		if (head != NULL && (GET_PREV_FREE(head) != NULL || GET_ALLOC(HDRP(head))
+		    || get_index(GET_SIZE(HDRP(head))) != i)){
+			printf("The head %p of list %lu is not a free block of the list\n", head, (unsigned long) i);
+			return 1;
 		}
 	}
 	return 0;
@@ -873,12 +2924,12 @@ static int  check_free_blk(char *blk){
 		return 1;
 	}
 	/*check if pointer from next block is inconsistent*/
-        if ((char *) GET(NEXT_FREE(blk)) != NULL && (char *) GET(PREV_FREE(GET(NEXT_FREE(blk)))) != blk){
+        if (GET_NEXT_FREE(blk) != NULL && GET_PREV_FREE(GET_NEXT_FREE(blk)) != blk){
                 printf("Free block pointer %p's next pointer is inconsistent\n", blk);
 		return 1;
 	}
         /*check if pointer from previous block is inconsistent*/
-        if ((char *) GET(PREV_FREE(blk)) != NULL && (char *) GET(NEXT_FREE(GET(PREV_FREE(blk)))) != blk){
+        if (GET_PREV_FREE(blk) != NULL && GET_NEXT_FREE(GET_PREV_FREE(blk)) != blk){
                 printf("Free block pointer %p's previous pointer is inconsistent\n", blk);
 		return 1;
 	}
@@ -922,7 +2973,7 @@ static void print_free_blk(char *bp){
 		dbg_printf("%p : header : [%2d : %c] footer : [%2d : %c]\n", bp, GET_SIZE(HDRP(bp)), \
 		(GET_ALLOC(HDRP(bp)) ? 'a' : 'f'), GET_SIZE(FTRP(bp)), \
 		(GET_ALLOC(FTRP(bp)) ? 'a' : 'f'));
-		dbg_printf("%p : next :[%p] previous : [%p]\n", bp, NEXT_FREE(bp), PREV_FREE(bp));
+		dbg_printf("%p : next :[%p] previous : [%p]\n", bp, GET_NEXT_FREE(bp), GET_PREV_FREE(bp));
 	}
 	else{
 		dbg_printf("%p block is null", bp);
@@ -0,0 +1,801 @@
+/*
+ * mdriver.c - Trace driven benchmark for the allocators
+ *
+ * Every trace is replayed against every allocator linked into the
+ * driver (see mm_seg.c, mm_tlsf.c, mm_rt.c, mm_seg_mt.c, mm_slab.c,
+ * mm_compact.c, mm_quick.c, mm_prof.c, mm_huge.c, mm_ckpt.c,
+ * mm_ckpt_tree.c and mm_arena.c), in three steps:
+ *   1. a validating run, that fills each payload with a pattern, checks
+ *      alignment and heap bounds, and checks the pattern is still intact
+ *      when the block is reallocated or freed, and that calloc returns
+ *      zeroed blocks and catches nmemb * size overflowing, and that
+ *      memalign returns blocks aligned as asked. This run also measures
+ *      peak heap size and utilization (peak live payload / peak heap),
+ *      the heap left once the trace has freed everything, and the
+ *      number of mem_sbrk calls it took. Blocks with mappings of their
+ *      own (see mem_map) count as heap too.
+ *   2. reps timed runs of the bare trace, reported as operations/second.
+ *   3. a summary line per allocator, so the two can be compared.
+ * The simulated heap is reset between runs (see memlib.c). With -s the
+ * allocator's own counters (see mm_stats) are printed too, as they
+ * stood when the live payload peaked: how the heap splits into
+ * allocated and free bytes, how fragmented the free bytes are, and how
+ * often blocks were split and coalesced and the heap grew and shrank.
+ * With -m the validating runs write SNAPSHOTS snapshots of the heap each,
+ * evenly spaced over the trace, to a file for heapmap to draw (see
+ * heapmap.h for the format). -C checks the heap after every operation
+ * like -c, but a slice at a time with mm_checkheap_step, so it keeps up
+ * on large traces. -M runs the configurations of mm_core.c instead (see
+ * mm_cores.c), every free block index, fit and block layout, and prints
+ * them as a matrix against the traces, throughput and utilization, with
+ * the best configuration for each trace.
+ *
+ * usage: mdriver [-hVcCvsM] [-a allocator] [-n reps] [-m file] <trace files...>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "heapmap.h"
+
+#define ALIGNMENT 8  /*every payload must be aligned to this many bytes*/
+#define MAXLINE   1024
+#define SNAPSHOTS 64 /*heap snapshots written per trace with -m*/
+
+/*one operation of a trace*/
+typedef struct {
+	char type;   /*'a', 'c', 'm', 'r' or 'f'*/
+	int id;      /*block id*/
+	size_t size; /*bytes requested, unused for 'f'*/
+	size_t align; /*alignment requested by 'm'*/
+} trace_op;
+
+/*a trace read from a file*/
+typedef struct {
+	const char *name;  /*file name without directory and suffix*/
+	int num_ids;       /*number of distinct block ids*/
+	int num_ops;       /*number of operations*/
+	trace_op *ops;
+	void **blocks;     /*current pointer of each id*/
+	size_t *sizes;     /*current size of each id*/
+} trace_t;
+
+/*what one allocator did on one trace*/
+typedef struct {
+	int valid;          /*validating run succeeded*/
+	double secs;        /*time of all timed runs*/
+	long ops;           /*operations executed by all timed runs*/
+	size_t peak_heap;   /*largest heap seen during the validating run*/
+	size_t end_heap;    /*heap left at the end of the validating run*/
+	long sbrks;         /*mem_sbrk calls of the validating run*/
+	size_t peak_live;   /*largest sum of live payload sizes*/
+	struct mm_heap_stats at_peak; /*the allocator's counters when peak_live was reached*/
+} run_stats;
+
+/*a heap snapshot being taken*/
+typedef struct {
+	struct heapmap_snap snap;
+	uint64_t *runs;    /*run words so far*/
+	size_t max_runs;   /*capacity of runs*/
+} snapshot;
+
+extern const struct mm_ops seg_mm_ops;
+extern const struct mm_ops tlsf_mm_ops;
+extern const struct mm_ops rt_mm_ops;
+extern const struct mm_ops seg_mt_mm_ops;
+extern const struct mm_ops slab_mm_ops;
+extern const struct mm_ops compact_mm_ops;
+extern const struct mm_ops quick_mm_ops;
+extern const struct mm_ops prof_mm_ops;
+extern const struct mm_ops huge_mm_ops;
+extern const struct mm_ops ckpt_mm_ops;
+extern const struct mm_ops ckpt_tree_mm_ops;
+extern const struct mm_ops arena_mm_ops;
+extern const struct mm_ops *const core_mm_ops[]; /*see mm_cores.c*/
+extern const int num_core_mm_ops;
+
+/*all allocators the driver knows about*/
+static const struct mm_ops *allocators[] = {
+	&seg_mm_ops,
+	&tlsf_mm_ops,
+	&rt_mm_ops,
+	&seg_mt_mm_ops,
+	&slab_mm_ops,
+	&compact_mm_ops,
+	&quick_mm_ops,
+	&prof_mm_ops,
+	&huge_mm_ops,
+	&ckpt_mm_ops,
+	&ckpt_tree_mm_ops,
+	&arena_mm_ops,
+};
+
+#define NUM_ALLOCATORS (sizeof(allocators) / sizeof(allocators[0]))
+
+static int verbose;        /*print each failure in detail*/
+static int check_heap;     /*call mm_checkheap after every operation*/
+static int check_step;     /*call mm_checkheap_step after every operation*/
+static int show_stats;     /*print the allocator's counters at peak payload*/
+static FILE *snap_file;    /*where the heap snapshots go, NULL for none*/
+static snapshot snap;
+
+static void usage(void){
+	size_t i;
+
+	fprintf(stderr, "usage: mdriver [-hVcCvsM] [-a allocator] [-n reps] [-m file] <trace files...>\n");
+	fprintf(stderr, "  -a name   only run this allocator (may be repeated)\n");
+	fprintf(stderr, "  -M        run every mm_core.c configuration as a matrix\n");
+	fprintf(stderr, "  -n reps   number of timed runs per trace (default 3)\n");
+	fprintf(stderr, "  -V        validate only, skip the timed runs\n");
+	fprintf(stderr, "  -c        call mm_checkheap after every operation\n");
+	fprintf(stderr, "  -C        call mm_checkheap_step after every operation\n");
+	fprintf(stderr, "  -v        verbose output\n");
+	fprintf(stderr, "  -s        print heap statistics at peak payload\n");
+	fprintf(stderr, "  -m file   write snapshots of the heap to file, for heapmap\n");
+	fprintf(stderr, "allocators:");
+	for (i = 0; i < NUM_ALLOCATORS; i++)
+		fprintf(stderr, " %s", allocators[i]->name);
+	for (i = 0; i < (size_t) num_core_mm_ops; i++)
+		fprintf(stderr, " %s", core_mm_ops[i]->name);
+	fprintf(stderr, "\n");
+}
+
+static void *xmalloc(size_t bytes){
+	void *p = malloc(bytes);
+
+	if (p == NULL){
+		fprintf(stderr, "mdriver: out of memory\n");
+		exit(1);
+	}
+	return p;
+}
+
+/*
+ * read_trace - Read a trace file into memory, return NULL on error
+ */
+static trace_t *read_trace(const char *path){
+	FILE *fp;
+	trace_t *t;
+	char type[MAXLINE];
+	const char *base;
+	char *dot;
+	int i, heap_size, weight;
+	unsigned long size, align;
+
+	if ((fp = fopen(path, "r")) == NULL){
+		fprintf(stderr, "mdriver: could not open %s\n", path);
+		return NULL;
+	}
+	t = xmalloc(sizeof(trace_t));
+	if (fscanf(fp, "%d %d %d %d", &heap_size, &t->num_ids, &t->num_ops, &weight) != 4
+	    || t->num_ids < 0 || t->num_ops < 0){
+		fprintf(stderr, "mdriver: bad header in %s\n", path);
+		fclose(fp);
+		free(t);
+		return NULL;
+	}
+	t->ops = xmalloc((t->num_ops + 1) * sizeof(trace_op));
+	t->blocks = xmalloc((t->num_ids + 1) * sizeof(void *));
+	t->sizes = xmalloc((t->num_ids + 1) * sizeof(size_t));
+
+	for (i = 0; i < t->num_ops; i++){
+		trace_op *op = &t->ops[i];
+
+		if (fscanf(fp, "%s", type) != 1)
+			break;
+		op->type = type[0];
+		op->size = 0;
+		if (op->type == 'a' || op->type == 'c' || op->type == 'r'){
+			if (fscanf(fp, "%d %lu", &op->id, &size) != 2)
+				break;
+			op->size = size;
+		}
+		else if (op->type == 'm'){
+			if (fscanf(fp, "%d %lu %lu", &op->id, &align, &size) != 3)
+				break;
+			op->align = align;
+			op->size = size;
+		}
+		else if (op->type == 'f'){
+			if (fscanf(fp, "%d", &op->id) != 1)
+				break;
+		}
+		else
+			break;
+		if (op->id < 0 || op->id >= t->num_ids)
+			break;
+	}
+	fclose(fp);
+	if (i != t->num_ops){
+		fprintf(stderr, "mdriver: bad operation %d in %s\n", i, path);
+		return NULL;
+	}
+
+	/*name the trace after the file, without directory and suffix*/
+	base = strrchr(path, '/');
+	base = base ? base + 1 : path;
+	t->name = strdup(base);
+	if ((dot = strrchr(t->name, '.')) != NULL)
+		*dot = '\0';
+	return t;
+}
+
+/*
+ * pattern_byte - The byte written at offset i of block id
+ */
+static unsigned char pattern_byte(int id, size_t i){
+	return (unsigned char) (id * 31 + (i >> 3));
+}
+
+/*
+ * fill_block - Write the pattern of id into the first size bytes of p
+ */
+static void fill_block(unsigned char *p, int id, size_t size){
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		p[i] = pattern_byte(id, i);
+}
+
+/*
+ * block_intact - Check that the first size bytes of p still hold the pattern of id
+ */
+static int block_intact(const unsigned char *p, int id, size_t size){
+	size_t i;
+
+	for (i = 0; i < size; i++){
+		if (p[i] != pattern_byte(id, i))
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * block_zero - Check that the first size bytes of p are zero
+ */
+static int block_zero(const unsigned char *p, size_t size){
+	size_t i;
+
+	for (i = 0; i < size; i++){
+		if (p[i] != 0)
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * footprint - Bytes the allocator holds: the heap plus its mappings
+ */
+static size_t footprint(void){
+	return mem_heapsize() + mem_mapped();
+}
+
+/*
+ * check_payload - Check a pointer returned by the allocator for
+ * NULL, alignment and being inside the heap or one of its mappings
+ */
+static int check_payload(const trace_t *t, int opnum, const void *p, size_t size){
+	const trace_op *op = &t->ops[opnum];
+
+	if (p == NULL){
+		fprintf(stderr, "%s: op %d (%c %d %lu) returned NULL\n", t->name, opnum,
+			op->type, op->id, (unsigned long) op->size);
+		return 0;
+	}
+	if ((size_t) p % ALIGNMENT){
+		fprintf(stderr, "%s: op %d returned %p, not aligned to %d bytes\n",
+			t->name, opnum, p, ALIGNMENT);
+		return 0;
+	}
+	if (((const char *) p < (char *) mem_heap_lo()
+	    || (const char *) p + size - 1 > (char *) mem_heap_hi())
+	    && !mem_is_mapped(p, size)){
+		fprintf(stderr, "%s: op %d returned [%p, %p), outside heap [%p, %p] and mappings\n",
+			t->name, opnum, p, (const char *) p + size, mem_heap_lo(), mem_heap_hi());
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * snap_visit - Add the block bp of size bytes to the snapshot being taken,
+ * as a run of its own or as part of the allocated run before it
+ */
+static void snap_visit(void *arg, void *bp, size_t size, int alloc){
+	snapshot *sn = arg;
+	struct heapmap_snap *hs = &sn->snap;
+
+	if (hs->num_runs == 0){
+		hs->first = (char *) bp - 4 - (char *) mem_heap_lo(); /*bp is past a 4 byte header*/
+	}
+	if (alloc){
+		hs->alloc_blocks++;
+		if (hs->num_runs > 0 && HEAPMAP_RUN_ALLOC(sn->runs[hs->num_runs - 1])){
+			sn->runs[hs->num_runs - 1] += HEAPMAP_RUN(size, 0);
+			return;
+		}
+	}
+	if (hs->num_runs == sn->max_runs){
+		sn->max_runs = sn->max_runs ? 2 * sn->max_runs : 1024;
+		if ((sn->runs = realloc(sn->runs, sn->max_runs * sizeof(uint64_t))) == NULL){
+			fprintf(stderr, "mdriver: out of memory\n");
+			exit(1);
+		}
+	}
+	sn->runs[hs->num_runs++] = HEAPMAP_RUN(size, alloc);
+}
+
+/*
+ * write_snapshot - Walk the heap after op ops of the trace and append
+ * what it holds to snap_file
+ */
+static void write_snapshot(const struct mm_ops *mm, const trace_t *t, int op){
+	struct heapmap_snap *hs = &snap.snap;
+	struct mm_heap_stats st;
+	int c;
+
+	memset(hs, 0, sizeof(*hs));
+	hs->magic = HEAPMAP_MAGIC;
+	hs->version = HEAPMAP_VERSION;
+	snprintf(hs->allocator, HEAPMAP_NAME, "%s", mm->name);
+	snprintf(hs->trace, HEAPMAP_NAME, "%s", t->name);
+	hs->op = op;
+	hs->num_ops = t->num_ops;
+	hs->heap_size = mem_heapsize();
+	mm->heap_walk(snap_visit, &snap);
+	mm->stats(&st);
+	for (c = 0; c < MM_SIZE_CLASSES; c++){
+		hs->class_blocks[c] = st.class_blocks[c];
+		hs->class_bytes[c] = st.class_bytes[c];
+	}
+	fwrite(hs, sizeof(*hs), 1, snap_file);
+	fwrite(snap.runs, sizeof(uint64_t), hs->num_runs, snap_file);
+}
+
+/*
+ * validate - Replay the trace once, checking everything the allocator
+ * returns, and measure peak heap and peak live payload
+ */
+static int validate(const struct mm_ops *mm, trace_t *t, run_stats *st){
+	size_t live = 0;
+	int i, every = t->num_ops / SNAPSHOTS > 0 ? t->num_ops / SNAPSHOTS : 1;
+
+	mem_reset_brk();
+	if (mm->init() < 0){
+		fprintf(stderr, "%s: mm_init failed\n", t->name);
+		return 0;
+	}
+	memset(t->blocks, 0, t->num_ids * sizeof(void *));
+	memset(t->sizes, 0, t->num_ids * sizeof(size_t));
+	st->peak_heap = footprint();
+	st->peak_live = 0;
+	if (mm->calloc((size_t) -1 / 2 + 2, 2) != NULL){
+		fprintf(stderr, "%s: calloc did not catch nmemb * size overflowing\n", t->name);
+		return 0;
+	}
+
+	for (i = 0; i < t->num_ops; i++){
+		trace_op *op = &t->ops[i];
+		unsigned char *p = t->blocks[op->id];
+		size_t old = t->sizes[op->id];
+
+		switch (op->type){
+		case 'a':
+			p = mm->malloc(op->size);
+			if (!check_payload(t, i, p, op->size))
+				return 0;
+			fill_block(p, op->id, op->size);
+			t->blocks[op->id] = p;
+			t->sizes[op->id] = op->size;
+			live += op->size;
+			break;
+		case 'c':
+			p = mm->calloc(op->size, 1);
+			if (!check_payload(t, i, p, op->size))
+				return 0;
+			if (!block_zero(p, op->size)){
+				fprintf(stderr, "%s: op %d, calloc returned block %d not zeroed\n",
+					t->name, i, op->id);
+				return 0;
+			}
+			fill_block(p, op->id, op->size);
+			t->blocks[op->id] = p;
+			t->sizes[op->id] = op->size;
+			live += op->size;
+			break;
+		case 'm':
+			p = mm->memalign(op->align, op->size);
+			if (!check_payload(t, i, p, op->size))
+				return 0;
+			if ((size_t) p % op->align){
+				fprintf(stderr, "%s: op %d returned %p, not aligned to %lu bytes\n",
+					t->name, i, p, (unsigned long) op->align);
+				return 0;
+			}
+			fill_block(p, op->id, op->size);
+			t->blocks[op->id] = p;
+			t->sizes[op->id] = op->size;
+			live += op->size;
+			break;
+		case 'r':
+			if (p != NULL && !block_intact(p, op->id, old)){
+				fprintf(stderr, "%s: op %d, block %d was overwritten before realloc\n",
+					t->name, i, op->id);
+				return 0;
+			}
+			p = mm->realloc(p, op->size);
+			if (!check_payload(t, i, p, op->size))
+				return 0;
+			if (!block_intact(p, op->id, old < op->size ? old : op->size)){
+				fprintf(stderr, "%s: op %d, realloc of block %d lost its contents\n",
+					t->name, i, op->id);
+				return 0;
+			}
+			fill_block(p, op->id, op->size);
+			t->blocks[op->id] = p;
+			t->sizes[op->id] = op->size;
+			live = live - old + op->size;
+			break;
+		case 'f':
+			if (p != NULL && !block_intact(p, op->id, old)){
+				fprintf(stderr, "%s: op %d, block %d was overwritten before free\n",
+					t->name, i, op->id);
+				return 0;
+			}
+			mm->free(p);
+			t->blocks[op->id] = NULL;
+			t->sizes[op->id] = 0;
+			live -= old;
+			break;
+		}
+		if (live > st->peak_live){
+			st->peak_live = live;
+			if (show_stats && mm->stats != NULL)
+				mm->stats(&st->at_peak);
+		}
+		if (footprint() > st->peak_heap)
+			st->peak_heap = footprint();
+		if (check_heap && mm->checkheap(verbose)){
+			fprintf(stderr, "%s: mm_checkheap failed after op %d\n", t->name, i);
+			return 0;
+		}
+		if (check_step && (mm->checkheap_step != NULL ? mm->checkheap_step(verbose)
+		    : mm->checkheap(verbose))){
+			fprintf(stderr, "%s: mm_checkheap_step failed after op %d\n", t->name, i);
+			return 0;
+		}
+		if (snap_file != NULL && mm->heap_walk != NULL
+		    && ((i + 1) % every == 0 || i + 1 == t->num_ops))
+			write_snapshot(mm, t, i + 1);
+	}
+	st->end_heap = footprint();
+	st->sbrks = mem_sbrk_calls();
+	return 1;
+}
+
+/*
+ * replay - Replay the trace once without any checking, as fast as possible
+ */
+static int replay(const struct mm_ops *mm, trace_t *t){
+	int i;
+
+	mem_reset_brk();
+	if (mm->init() < 0)
+		return 0;
+	for (i = 0; i < t->num_ops; i++){
+		trace_op *op = &t->ops[i];
+
+		switch (op->type){
+		case 'a':
+			if ((t->blocks[op->id] = mm->malloc(op->size)) == NULL)
+				return 0;
+			break;
+		case 'c':
+			if ((t->blocks[op->id] = mm->calloc(op->size, 1)) == NULL)
+				return 0;
+			break;
+		case 'm':
+			if ((t->blocks[op->id] = mm->memalign(op->align, op->size)) == NULL)
+				return 0;
+			break;
+		case 'r':
+			if ((t->blocks[op->id] = mm->realloc(t->blocks[op->id], op->size)) == NULL)
+				return 0;
+			break;
+		case 'f':
+			mm->free(t->blocks[op->id]);
+			t->blocks[op->id] = NULL;
+			break;
+		}
+	}
+	return 1;
+}
+
+static double now(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * run_trace - Validate and then time one allocator on one trace
+ */
+static void run_trace(const struct mm_ops *mm, trace_t *t, int reps, run_stats *st){
+	double start;
+	int r;
+
+	memset(st, 0, sizeof(run_stats));
+	st->valid = validate(mm, t, st);
+	if (!st->valid || reps == 0)
+		return;
+
+	start = now();
+	for (r = 0; r < reps; r++){
+		if (!replay(mm, t)){
+			st->valid = 0;
+			return;
+		}
+		st->ops += t->num_ops;
+	}
+	st->secs = now() - start;
+}
+
+/*
+ * print_results - One line per trace and a summary for an allocator
+ */
+static void print_results(const struct mm_ops *mm, trace_t **traces, run_stats *st,
+	int num_traces, int timed){
+	double secs = 0, util = 0;
+	long ops = 0, sbrks = 0;
+	int i, valid = 1;
+
+	printf("\nResults for %s:\n", mm->name);
+	printf("%-12s %5s %9s %9s %10s %11s %7s %11s %7s\n",
+		"trace", "valid", "ops", "secs", "Kops/s", "peak heap", "util", "end heap", "sbrks");
+	for (i = 0; i < num_traces; i++){
+		double u = st[i].peak_heap ? (double) st[i].peak_live / st[i].peak_heap : 0;
+
+		if (!st[i].valid){
+			printf("%-12s %5s\n", traces[i]->name, "no");
+			valid = 0;
+			continue;
+		}
+		printf("%-12s %5s %9d", traces[i]->name, "yes", traces[i]->num_ops);
+		if (timed && st[i].secs > 0)
+			printf(" %9.4f %10.1f", st[i].secs, st[i].ops / st[i].secs / 1e3);
+		else
+			printf(" %9s %10s", "-", "-");
+		printf(" %11lu %6.1f%% %11lu %7ld\n", (unsigned long) st[i].peak_heap, 100 * u,
+			(unsigned long) st[i].end_heap, st[i].sbrks);
+		secs += st[i].secs;
+		sbrks += st[i].sbrks;
+		ops += st[i].ops;
+		util += u;
+	}
+	if (!valid){
+		printf("%-12s %5s\n", "Total", "no");
+		return;
+	}
+	printf("%-12s %5s %9s", "Total", "", "");
+	if (timed && secs > 0)
+		printf(" %9.4f %10.1f", secs, ops / secs / 1e3);
+	else
+		printf(" %9s %10s", "-", "-");
+	printf(" %11s %6.1f%% %11s %7ld\n", "", 100 * util / num_traces, "", sbrks);
+}
+
+/*
+ * print_heap_stats - The allocator's counters at peak payload, one line
+ * per trace: the heap and its allocated and free bytes, the share of the
+ * free bytes outside the largest size class holding any, as a measure
+ * of how fragmented they are, and the structural events of the run
+ */
+static void print_heap_stats(const struct mm_ops *mm, trace_t **traces, run_stats *st,
+	int num_traces){
+	int i, c;
+
+	if (mm->stats == NULL)
+		return;
+	printf("\nHeap at peak payload for %s:\n", mm->name);
+	printf("%-12s %11s %11s %11s %9s %6s %9s %9s %7s %6s\n", "trace", "heap", "allocated",
+		"free", "free blks", "frag", "splits", "coalesces", "extends", "trims");
+	for (i = 0; i < num_traces; i++){
+		const struct mm_heap_stats *hs = &st[i].at_peak;
+		double frag = 0;
+
+		if (!st[i].valid)
+			continue;
+		for (c = MM_SIZE_CLASSES - 1; c > 0 && hs->class_blocks[c] == 0; c--)
+			;
+		if (hs->free_bytes > 0)
+			frag = 1 - (double) hs->class_bytes[c] / hs->free_bytes;
+		printf("%-12s %11lu %11lu %11lu %9lu %5.1f%% %9lu %9lu %7lu %6lu\n", traces[i]->name,
+			(unsigned long) hs->heap_size, (unsigned long) hs->alloc_bytes,
+			(unsigned long) hs->free_bytes, (unsigned long) hs->free_blocks, 100 * frag,
+			hs->splits, hs->coalesces, hs->extends, hs->trims);
+	}
+}
+
+/*
+ * find_allocator - The allocator or mm_core.c configuration called name,
+ * or NULL
+ */
+static const struct mm_ops *find_allocator(const char *name){
+	size_t i;
+
+	for (i = 0; i < NUM_ALLOCATORS; i++){
+		if (strcmp(name, allocators[i]->name) == 0)
+			return allocators[i];
+	}
+	for (i = 0; i < (size_t) num_core_mm_ops; i++){
+		if (strcmp(name, core_mm_ops[i]->name) == 0)
+			return core_mm_ops[i];
+	}
+	return NULL;
+}
+
+/*
+ * print_matrix - Throughput and utilization of every allocator (row) on
+ * every trace (column), then the allocator doing best on each trace by
+ * either measure. st holds num_traces results per allocator.
+ */
+static void print_matrix(const struct mm_ops **mms, int num_mms, trace_t **traces, run_stats *st,
+	int num_traces, int timed){
+	const char *title[2] = {"Kops/s", "utilization %"};
+	double v, best[2];
+	int m, i, k, arg[2];
+
+	for (k = timed ? 0 : 1; k < 2; k++){
+		printf("\n%s:\n%-16s", title[k], "allocator");
+		for (i = 0; i < num_traces; i++)
+			printf(" %9.9s", traces[i]->name);
+		printf("\n");
+		for (m = 0; m < num_mms; m++){
+			printf("%-16s", mms[m]->name);
+			for (i = 0; i < num_traces; i++){
+				const run_stats *r = &st[m * num_traces + i];
+
+				if (!r->valid)
+					printf(" %9s", "no");
+				else if (k == 0)
+					printf(" %9.0f", r->secs > 0 ? r->ops / r->secs / 1e3 : 0);
+				else
+					printf(" %9.1f", r->peak_heap ? 100.0 * r->peak_live / r->peak_heap : 0);
+			}
+			printf("\n");
+		}
+	}
+	printf("\nBest allocator per trace:\n%-12s %-16s %10s %-16s %7s\n",
+		"trace", "fastest", "Kops/s", "tightest", "util");
+	for (i = 0; i < num_traces; i++){
+		arg[0] = arg[1] = -1;
+		best[0] = best[1] = -1;
+		for (m = 0; m < num_mms; m++){
+			const run_stats *r = &st[m * num_traces + i];
+
+			if (!r->valid)
+				continue;
+			v = r->secs > 0 ? r->ops / r->secs / 1e3 : 0;
+			if (timed && v > best[0]){
+				best[0] = v;
+				arg[0] = m;
+			}
+			v = r->peak_heap ? 100.0 * r->peak_live / r->peak_heap : 0;
+			if (v > best[1]){
+				best[1] = v;
+				arg[1] = m;
+			}
+		}
+		printf("%-12s", traces[i]->name);
+		if (arg[0] >= 0)
+			printf(" %-16s %10.0f", mms[arg[0]]->name, best[0]);
+		else
+			printf(" %-16s %10s", "-", "-");
+		if (arg[1] >= 0)
+			printf(" %-16s %6.1f%%\n", mms[arg[1]]->name, best[1]);
+		else
+			printf(" %-16s %7s\n", "-", "-");
+	}
+}
+
+int main(int argc, char **argv){
+	const struct mm_ops **selected;
+	trace_t **traces;
+	run_stats *st;
+	int num_selected = 0, num_traces, reps = 3, matrix = 0;
+	int i, c, failed = 0;
+	size_t j;
+
+	selected = xmalloc((argc + NUM_ALLOCATORS + num_core_mm_ops) * sizeof(*selected));
+	while ((c = getopt(argc, argv, "a:n:m:VcCvsMh")) != -1){
+		switch (c){
+		case 'a':
+			if ((selected[num_selected++] = find_allocator(optarg)) == NULL){
+				fprintf(stderr, "mdriver: unknown allocator %s\n", optarg);
+				usage();
+				return 1;
+			}
+			break;
+		case 'M':
+			matrix = 1;
+			break;
+		case 'n':
+			reps = atoi(optarg);
+			if (reps < 1)
+				reps = 1;
+			break;
+		case 'V':
+			reps = 0;
+			break;
+		case 'c':
+			check_heap = 1;
+			break;
+		case 'C':
+			check_step = 1;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		case 's':
+			show_stats = 1;
+			break;
+		case 'm':
+			if ((snap_file = fopen(optarg, "wb")) == NULL){
+				perror(optarg);
+				return 1;
+			}
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+	if (optind == argc){
+		usage();
+		return 1;
+	}
+	if (num_selected == 0 && matrix){ /*the matrix is of the configurations by default*/
+		for (i = 0; i < num_core_mm_ops; i++)
+			selected[num_selected++] = core_mm_ops[i];
+	}
+	else if (num_selected == 0){ /*run everything by default*/
+		for (j = 0; j < NUM_ALLOCATORS; j++)
+			selected[num_selected++] = allocators[j];
+	}
+
+	num_traces = argc - optind;
+	traces = xmalloc(num_traces * sizeof(trace_t *));
+	for (i = 0; i < num_traces; i++){
+		if ((traces[i] = read_trace(argv[optind + i])) == NULL)
+			return 1;
+	}
+
+	mem_init();
+	st = xmalloc((size_t) num_selected * num_traces * sizeof(run_stats));
+	for (j = 0; j < (size_t) num_selected; j++){
+		run_stats *sj = &st[j * num_traces];
+
+		for (i = 0; i < num_traces; i++){
+			run_trace(selected[j], traces[i], reps, &sj[i]);
+			failed |= !sj[i].valid;
+		}
+		if (matrix)
+			continue;
+		print_results(selected[j], traces, sj, num_traces, reps > 0);
+		if (show_stats)
+			print_heap_stats(selected[j], traces, sj, num_traces);
+	}
+	if (matrix)
+		print_matrix(selected, num_selected, traces, st, num_traces, reps > 0);
+	mem_deinit();
+	if (snap_file != NULL && fclose(snap_file) != 0){
+		perror("mdriver: writing snapshots");
+		return 1;
+	}
+	return failed;
+}
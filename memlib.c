@@ -0,0 +1,380 @@
+/*
+ * memlib.c - A stand-in for the sbrk and mmap system calls used by the allocators
+ *
+ * We reserve MAX_HEAP bytes of address space with mmap once, and mem_sbrk
+ * simply moves a break pointer inside that region. The kernel only commits
+ * pages as they are touched, so the reservation itself costs nothing.
+ * Shrinking the heap with mem_shrink and mem_reset_brk hand the pages given
+ * up back with MADV_DONTNEED, so each new run of a trace starts from fresh,
+ * zero filled memory, just like memory new from the kernel. The reservation starts on
+ * a huge page boundary (MEM_HUGE_PAGE), so an allocator that grows the
+ * heap a huge page at a time can have it backed by transparent huge pages
+ * once it asks for them with mem_hugepage; mem_reset_brk then maps the
+ * reservation afresh, so the next allocator starts without the advice.
+ *
+ * mem_map, mem_remap and mem_unmap pass through to the kernel, but keep
+ * a table of the live mappings, so the driver can count their bytes and
+ * check that a block handed out lies inside one of them. The table sits
+ * in its own mapping (the allocator under test may be the process malloc)
+ * and is guarded by a lock, since a thread safe allocator maps without
+ * holding its own heap lock. Built with -DMEM_UNTRACKED, for running real
+ * programs on an allocator (see mm_preload.c), there is no table: mappings
+ * are only counted, and mem_is_mapped always says no.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "memlib.h"
+
+/*one live mapping*/
+typedef struct {
+	char *start;
+	size_t len;
+} mem_mapping;
+
+/* private global variables */
+static char *mem_start_brk;  /* points to first byte of heap */
+static char *mem_brk;        /* points to last byte of heap plus one */
+static char *mem_max_addr;   /* largest legal heap address plus one */
+static long sbrk_calls;      /* mem_sbrk and mem_shrink calls since the last reset */
+static int huge_advised;     /* mem_hugepage was called since the last reset */
+
+static size_t mapped_bytes;  /* sum of the lengths of live mappings */
+#ifndef MEM_UNTRACKED
+static mem_mapping *maps;    /* live mappings, in no particular order */
+static size_t num_maps;      /* number of live mappings */
+static size_t max_maps;      /* capacity of maps */
+static pthread_mutex_t maps_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/*
+ * mem_init - Reserve the region that will back the simulated heap,
+ * aligned to MEM_HUGE_PAGE by reserving that much more and giving back
+ * what lies outside the aligned part
+ */
+void mem_init(void){
+	char *p, *start;
+
+	p = mmap(NULL, MAX_HEAP + MEM_HUGE_PAGE, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (p == MAP_FAILED){ /*cannot go on without a heap*/
+		fprintf(stderr, "mem_init: mmap of %lu bytes failed\n", (unsigned long) MAX_HEAP);
+		exit(1);
+	}
+	start = (char *) (((size_t) p + MEM_HUGE_PAGE - 1) & ~(MEM_HUGE_PAGE - 1));
+	if (start > p)
+		munmap(p, start - p);
+	munmap(start + MAX_HEAP, p + MEM_HUGE_PAGE - start);
+	mem_start_brk = start;
+	mem_brk = mem_start_brk; /*heap is empty initially*/
+	mem_max_addr = mem_start_brk + MAX_HEAP;
+}
+
+/*
+ * mem_deinit - Give the whole reservation and all mappings back to the kernel
+ */
+void mem_deinit(void){
+	mem_reset_brk();
+	munmap(mem_start_brk, MAX_HEAP);
+	mem_start_brk = mem_brk = mem_max_addr = NULL;
+#ifndef MEM_UNTRACKED
+	if (maps != NULL){
+		munmap(maps, max_maps * sizeof(mem_mapping));
+		maps = NULL;
+		max_maps = 0;
+	}
+#endif
+}
+
+/*
+ * mem_reset_brk - Reset the simulated brk pointer to make an empty heap,
+ * drop the pages that were touched, so they read back as zero, and
+ * unmap whatever mappings the last run left behind
+ */
+void mem_reset_brk(void){
+	if (huge_advised){ /*drop the advice along with the pages*/
+		mmap(mem_start_brk, MAX_HEAP, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+		huge_advised = 0;
+	}
+	else if (mem_brk > mem_start_brk){
+		madvise(mem_start_brk, mem_brk - mem_start_brk, MADV_DONTNEED);
+	}
+	mem_brk = mem_start_brk;
+	sbrk_calls = 0;
+
+#ifndef MEM_UNTRACKED
+	pthread_mutex_lock(&maps_lock);
+	while (num_maps > 0){
+		num_maps--;
+		munmap(maps[num_maps].start, maps[num_maps].len);
+	}
+	mapped_bytes = 0;
+	pthread_mutex_unlock(&maps_lock);
+#endif
+}
+
+/*
+ * mem_sbrk - Simple model of the sbrk function. Extends the heap
+ * by incr bytes and returns the start address of the new area. The
+ * increment is a size_t, so a heap of more than 2 GB (MAX_HEAP in the
+ * preloaded library) grows by any amount without it being truncated,
+ * and the heap only shrinks with mem_shrink.
+ */
+void *mem_sbrk(size_t incr){
+	char *old_brk = mem_brk;
+
+	sbrk_calls++;
+	if (incr > (size_t) (mem_max_addr - mem_brk)){
+		errno = ENOMEM;
+		fprintf(stderr, "ERROR: mem_sbrk failed. Ran out of memory...\n");
+		return (void *) -1;
+	}
+	mem_brk += incr;
+	return (void *) old_brk;
+}
+
+/*
+ * mem_shrink - Shrink the heap by decr bytes, giving the whole pages
+ * given up back to the kernel. Returns 0, or -1 if the heap is smaller.
+ */
+int mem_shrink(size_t decr){
+	char *old_brk = mem_brk;
+	size_t page = mem_pagesize();
+	char *first_page;
+
+	sbrk_calls++;
+	if (decr > (size_t) (mem_brk - mem_start_brk)){
+		errno = EINVAL;
+		fprintf(stderr, "ERROR: mem_shrink failed. The heap is smaller...\n");
+		return -1;
+	}
+	mem_brk -= decr;
+	first_page = (char *) (((size_t) mem_brk + page - 1) & ~(page - 1));
+	if (first_page < old_brk){
+		madvise(first_page, old_brk - first_page, MADV_DONTNEED);
+	}
+	return 0;
+}
+
+/*
+ * mem_hugepage - Ask for the len bytes of the heap reservation at p, both
+ * multiples of MEM_HUGE_PAGE, to be backed by transparent huge pages.
+ * Returns 0, or -1 if the kernel cannot.
+ */
+int mem_hugepage(void *p, size_t len){
+	huge_advised = 1;
+	return madvise(p, len, MADV_HUGEPAGE);
+}
+
+/*
+ * mem_heap_lo - Return address of the first heap byte
+ */
+void *mem_heap_lo(void){
+	return (void *) mem_start_brk;
+}
+
+/*
+ * mem_heap_hi - Return address of last heap byte
+ */
+void *mem_heap_hi(void){
+	return (void *) (mem_brk - 1);
+}
+
+/*
+ * mem_heapsize - Returns the heap size in bytes
+ */
+size_t mem_heapsize(void){
+	return (size_t) (mem_brk - mem_start_brk);
+}
+
+/*
+ * mem_sbrk_calls - Returns the number of mem_sbrk and mem_shrink calls since
+ * the heap was last reset, the system calls a real sbrk would have cost
+ */
+long mem_sbrk_calls(void){
+	return sbrk_calls;
+}
+
+/*
+ * mem_pagesize - Returns the page size of the system
+ */
+size_t mem_pagesize(void){
+	return (size_t) getpagesize();
+}
+
+#ifndef MEM_UNTRACKED
+/*
+ * find_map - Index of the mapping starting at p, or num_maps.
+ * Called with maps_lock held.
+ */
+static size_t find_map(const void *p){
+	size_t i;
+
+	for (i = 0; i < num_maps; i++){
+		if (maps[i].start == (const char *) p)
+			break;
+	}
+	return i;
+}
+
+/*
+ * add_map - Remember a new mapping, growing the table if it is full.
+ * Called with maps_lock held.
+ */
+static int add_map(char *start, size_t len){
+	mem_mapping *bigger;
+	size_t new_max;
+
+	if (num_maps == max_maps){
+		new_max = max_maps ? 2 * max_maps : mem_pagesize() / sizeof(mem_mapping);
+		bigger = mmap(NULL, new_max * sizeof(mem_mapping), PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (bigger == MAP_FAILED)
+			return -1;
+		if (maps != NULL){
+			memcpy(bigger, maps, num_maps * sizeof(mem_mapping));
+			munmap(maps, max_maps * sizeof(mem_mapping));
+		}
+		maps = bigger;
+		max_maps = new_max;
+	}
+	maps[num_maps].start = start;
+	maps[num_maps].len = len;
+	num_maps++;
+	mapped_bytes += len;
+	return 0;
+}
+#endif
+
+/*
+ * mem_map - Map len bytes (a multiple of the page size) of fresh,
+ * zero filled memory. Returns NULL on failure.
+ */
+void *mem_map(size_t len){
+	void *p;
+
+	p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		return NULL;
+#ifndef MEM_UNTRACKED
+	pthread_mutex_lock(&maps_lock);
+	if (add_map(p, len) < 0){
+		pthread_mutex_unlock(&maps_lock);
+		munmap(p, len);
+		return NULL;
+	}
+	pthread_mutex_unlock(&maps_lock);
+#else
+	__atomic_add_fetch(&mapped_bytes, len, __ATOMIC_RELAXED);
+#endif
+	return p;
+}
+
+/*
+ * mem_map_aligned - Map len bytes (a multiple of the page size) aligned
+ * to align bytes (a power of two multiple of the page size), by mapping
+ * align bytes more and giving back what lies outside the aligned part.
+ * Returns NULL on failure.
+ */
+void *mem_map_aligned(size_t len, size_t align){
+	char *p, *q;
+
+	p = mmap(NULL, len + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		return NULL;
+	q = (char *) (((size_t) p + align - 1) & ~(align - 1));
+	if (q > p)
+		munmap(p, q - p);
+	munmap(q + len, p + align - q);
+#ifndef MEM_UNTRACKED
+	pthread_mutex_lock(&maps_lock);
+	if (add_map(q, len) < 0){
+		pthread_mutex_unlock(&maps_lock);
+		munmap(q, len);
+		return NULL;
+	}
+	pthread_mutex_unlock(&maps_lock);
+#else
+	__atomic_add_fetch(&mapped_bytes, len, __ATOMIC_RELAXED);
+#endif
+	return q;
+}
+
+/*
+ * mem_remap - Resize the mapping at p from old_len to new_len bytes,
+ * moving it if it cannot grow where it is. The contents are kept
+ * without copying. Returns the new address, or NULL on failure.
+ */
+void *mem_remap(void *p, size_t old_len, size_t new_len){
+	void *q;
+#ifndef MEM_UNTRACKED
+	size_t i;
+#endif
+
+	q = mremap(p, old_len, new_len, MREMAP_MAYMOVE);
+	if (q == MAP_FAILED)
+		return NULL;
+#ifndef MEM_UNTRACKED
+	pthread_mutex_lock(&maps_lock);
+	if ((i = find_map(p)) < num_maps){
+		maps[i].start = q;
+		maps[i].len = new_len;
+		mapped_bytes = mapped_bytes - old_len + new_len;
+	}
+	pthread_mutex_unlock(&maps_lock);
+#else
+	__atomic_add_fetch(&mapped_bytes, new_len - old_len, __ATOMIC_RELAXED);
+#endif
+	return q;
+}
+
+/*
+ * mem_unmap - Give the mapping at p of len bytes back to the kernel
+ */
+void mem_unmap(void *p, size_t len){
+#ifndef MEM_UNTRACKED
+	size_t i;
+
+	pthread_mutex_lock(&maps_lock);
+	if ((i = find_map(p)) < num_maps){
+		mapped_bytes -= maps[i].len;
+		maps[i] = maps[--num_maps];
+	}
+	pthread_mutex_unlock(&maps_lock);
+#else
+	__atomic_sub_fetch(&mapped_bytes, len, __ATOMIC_RELAXED);
+#endif
+	munmap(p, len);
+}
+
+/*
+ * mem_mapped - Total bytes of all live mappings
+ */
+size_t mem_mapped(void){
+	return mapped_bytes;
+}
+
+/*
+ * mem_is_mapped - Whether [p, p + len) lies inside one live mapping
+ */
+int mem_is_mapped(const void *p, size_t len){
+	int found = 0;
+#ifndef MEM_UNTRACKED
+	const char *c = (const char *) p;
+	size_t i;
+
+	pthread_mutex_lock(&maps_lock);
+	for (i = 0; i < num_maps && !found; i++){
+		found = c >= maps[i].start && c + len <= maps[i].start + maps[i].len;
+	}
+	pthread_mutex_unlock(&maps_lock);
+#endif
+	return found;
+}
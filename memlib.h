@@ -0,0 +1,43 @@
+/*
+ * memlib.h - Interface to the simulated heap used by the allocators
+ *
+ * The heap is a single contiguous region that the allocator grows
+ * through mem_sbrk, exactly like the sbrk system call, and shrinks
+ * through mem_shrink. Blocks too large for the heap get their own
+ * mappings through mem_map, mem_remap and mem_unmap, the stand-ins for
+ * mmap, mremap and munmap; mem_map_aligned maps at an address aligned
+ * to a power of two.
+ */
+#ifndef __MEMLIB_H__
+#define __MEMLIB_H__
+
+#include <unistd.h>
+
+/* Largest heap the model can hand out (address space is reserved, not committed) */
+#ifndef MAX_HEAP
+#define MAX_HEAP (1UL << 30)
+#endif
+
+/* Size of a transparent huge page, the heap starts on a multiple of it */
+#define MEM_HUGE_PAGE (2UL << 20)
+
+void mem_init(void);
+void mem_deinit(void);
+void *mem_sbrk(size_t incr);
+int mem_shrink(size_t decr);
+int mem_hugepage(void *p, size_t len);
+void mem_reset_brk(void);
+void *mem_heap_lo(void);
+void *mem_heap_hi(void);
+size_t mem_heapsize(void);
+long mem_sbrk_calls(void);
+size_t mem_pagesize(void);
+
+void *mem_map(size_t len);
+void *mem_map_aligned(size_t len, size_t align);
+void *mem_remap(void *p, size_t old_len, size_t new_len);
+void mem_unmap(void *p, size_t len);
+size_t mem_mapped(void);
+int mem_is_mapped(const void *p, size_t len);
+
+#endif /* __MEMLIB_H__ */
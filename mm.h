@@ -0,0 +1,88 @@
+/*
+ * mm.h - Interface exported by the allocators in malloc_lab.c and
+ * malloc_checkpoint.c when they are built with -DDRIVER
+ */
+#ifndef __MM_H__
+#define __MM_H__
+
+#include <stdio.h>
+
+/*
+ * What mm_stats reports: cheap counters kept up to date as the heap
+ * changes, so they can be read at any time without walking the heap.
+ * Free blocks are counted per power of two size class: class i holds
+ * the blocks of 2^i to 2^(i+1) - 1 bytes.
+ */
+#define MM_SIZE_CLASSES    32
+#define MM_SIZE_CLASS(size) (63 - __builtin_clzl(size))
+
+struct mm_heap_stats {
+	size_t heap_size;      /*bytes of heap now*/
+	size_t peak_heap;      /*most bytes of heap since mm_init*/
+	size_t alloc_bytes;    /*bytes of allocated blocks, headers included*/
+	size_t free_bytes;     /*bytes of free blocks*/
+	size_t free_blocks;    /*number of free blocks*/
+	size_t mapped_bytes;   /*bytes of blocks with mappings of their own*/
+	size_t mapped_blocks;  /*number of those blocks*/
+	size_t class_bytes[MM_SIZE_CLASSES];  /*free bytes per size class*/
+	size_t class_blocks[MM_SIZE_CLASSES]; /*free blocks per size class*/
+	unsigned long splits;     /*free blocks split to allocate part of them*/
+	unsigned long coalesces;  /*free blocks merged with a free neighbour*/
+	unsigned long extends;    /*times the heap grew*/
+	unsigned long trims;      /*times the heap shrank*/
+};
+
+extern int mm_init(void);
+extern void *mm_malloc(size_t size);
+extern void mm_free(void *ptr);
+extern void *mm_realloc(void *ptr, size_t size);
+extern void *mm_calloc(size_t nmemb, size_t size);
+extern void *mm_memalign(size_t alignment, size_t size);
+extern int mm_posix_memalign(void **memptr, size_t alignment, size_t size);
+extern void *mm_aligned_alloc(size_t alignment, size_t size);
+extern size_t mm_malloc_usable_size(void *ptr);
+extern void mm_free_sized(void *ptr, size_t size);  /*malloc_lab.c only*/
+extern void mm_free_many(void **ptrs, size_t n);    /*malloc_lab.c only*/
+extern size_t mm_malloc_batch(size_t size, size_t n, void **out); /*malloc_lab.c only*/
+extern int mm_checkheap(int verbose);
+extern int mm_checkheap_step(int verbose);    /*malloc_lab.c only*/
+extern void mm_stats(struct mm_heap_stats *st);
+extern void mm_heap_walk(void (*visit)(void *arg, void *bp, size_t size, int alloc), void *arg);
+extern void mm_profile_rate(size_t bytes);    /*malloc_lab.c -DMM_PROFILE only*/
+extern int mm_profile_dump(const char *path); /*malloc_lab.c -DMM_PROFILE only*/
+
+/*
+ * Regions of objects that die together, freed all at once by
+ * mm_region_destroy (malloc_lab.c only)
+ */
+struct mm_region;
+
+extern struct mm_region *mm_region_create(size_t size);
+extern void *mm_region_alloc(struct mm_region *r, size_t size);
+extern void mm_region_destroy(struct mm_region *r);
+
+/*
+ * Both allocators export the same mm_* names, so the benchmark driver
+ * builds each one in its own wrapper (mm_seg.c, mm_ckpt.c) that renames
+ * the entry points and publishes them through one of these tables, all
+ * done by mm_wrap.h.
+ */
+struct mm_ops {
+	const char *name;                          /*short name printed by the driver*/
+	int (*init)(void);
+	void *(*malloc)(size_t size);
+	void (*free)(void *ptr);
+	void *(*realloc)(void *ptr, size_t size);
+	void *(*calloc)(size_t nmemb, size_t size);
+	void *(*memalign)(size_t alignment, size_t size);
+	int (*checkheap)(int verbose);
+	void (*free_sized)(void *ptr, size_t size);   /*NULL if not supported*/
+	void (*free_many)(void **ptrs, size_t n);     /*NULL if not supported*/
+	size_t (*malloc_batch)(size_t size, size_t n, void **out); /*NULL if not supported*/
+	void (*stats)(struct mm_heap_stats *st);
+	size_t (*usable_size)(void *ptr);
+	void (*heap_walk)(void (*visit)(void *arg, void *bp, size_t size, int alloc), void *arg);
+	int (*checkheap_step)(int verbose);           /*NULL if not supported*/
+};
+
+#endif /* __MM_H__ */
@@ -0,0 +1,10 @@
+/*
+ * mm_arena.c - Builds the allocator with an arena per thread
+ * (malloc_arena.c) for the benchmark drivers
+ */
+#define MM_PREFIX    arena_
+#define MM_LABEL     "arena"
+#define MM_SOURCE    "malloc_arena.c"
+#define MM_BASIC
+
+#include "mm_wrap.h"
@@ -0,0 +1,452 @@
+/*
+ * mm_block.h - The blocks every allocator here is built on: boundary
+ * tags, splitting, coalescing, heap extension and the free lists
+ *
+ * A block is a 4 byte header (size | MMAPPED | PREV_ALLOC | ALLOC), the
+ * payload, and for a free block a copy of the header as footer, with the
+ * next and previous links of its free list at the start of the payload.
+ * How much of that an allocated block keeps is the layout:
+ *   LAYOUT_PREV  no footer, a bit in the header of the block after it
+ *                tells it is allocated (malloc_lab.c, malloc_arena.c)
+ *   LAYOUT_TAGS  a footer on every block, PREV_ALLOC is never set
+ *                (malloc_checkpoint.c)
+ * A heap is a padding word, a prologue block of DSIZE bytes, the blocks,
+ * and an epilogue header of size 0.
+ *
+ * The first part, the layout, is read once. The second is a template of
+ * the functions on blocks, read each time this file is included with
+ * BLOCK_STATS set, once per allocator (once per configuration by
+ * mm_core.c), which sets
+ *   BLOCK(name)      name of each function, block_name if not set
+ *   BLOCK_LAYOUT     LAYOUT_PREV if not set
+ *   BLOCK_HEAP       parameter of the heap state, passed first to each
+ *   BLOCK_HEAP_ARG   function as BLOCK_HEAP_ARG, both empty if not set
+ *   BLOCK_STATS      the struct mm_heap_stats the counters go to
+ * and the free block index: either its own BLOCK_ADD(bp, size) and
+ * BLOCK_REM(bp, size), or the lists here, whose heads are the char *
+ * lvalues LIST_HEAD(i), with
+ *   LIST_INDEX(size), LIST_MARK(i), LIST_UNMARK(i)  the list of a block
+ *                    of size bytes and how the list is marked non-empty
+ *                    and empty, if not set malloc_lab.c's SEG_LISTS
+ *                    powers of two marked in the bitmap LIST_BITMAP
+ *   LIST_TAIL(i)     if set, the last block of each list, a freed block
+ *                    going last (FIFO) instead of first (LIFO)
+ * Optional hooks are BLOCK_MERGED(bp, size), run when blocks merged into
+ * the size bytes at bp and it is on its list, and BLOCK_LOAD_HDR(bp) and
+ * BLOCK_STORE_HDR(bp, val), how the header of the block after a changed
+ * one is read and written. An allocator that gives large blocks mappings
+ * of their own sets BLOCK_MAPPED, the struct mm_heap_stats they count in.
+ */
+#ifndef __MM_BLOCK_H__
+#define __MM_BLOCK_H__
+
+#include <limits.h>
+
+#include "mm.h"
+#include "memlib.h"
+
+#define LAYOUT_TAGS 0
+#define LAYOUT_PREV 1
+
+#define WSIZE       4
+#define DSIZE       8
+
+#define ALLOC       0x01
+#define PREV_ALLOC  0x02
+#define MMAPPED     0x04 /*block has a mapping of its own, set in its header only*/
+
+#define MAX(x, y)   ((x) > (y) ? (x) : (y))
+#define MIN(x, y)   ((x) < (y) ? (x) : (y))
+
+/* Pack a size and the bits into one header */
+#define PACK(size, bits)    ((unsigned) ((size) | (bits)))
+
+/* Read and write 8 and 4 bytes at address p */
+#define GET(p)              (*(size_t *) (p))
+#define PUT(p, val)         (*(size_t *) (p) = (val))
+#define GET_4(p)            (*(unsigned *) (p))
+#define PUT_4(p, val)       (*(unsigned *) (p) = (val))
+
+/* Read the size and the bits of the header or footer at p */
+#define GET_SIZE(p)         (GET_4(p) & ~0x7)
+#define GET_PREV_ALLOC(p)   (GET_4(p) & PREV_ALLOC)
+#define GET_ALLOC(p)        (GET_4(p) & ALLOC)
+
+/* For a block pointer bp, its header and footer, and the blocks next to it */
+#define HDRP(bp)            ((char *) (bp) - WSIZE)
+#define FTRP(bp)            ((char *) (bp) + GET_SIZE(HDRP(bp)) - DSIZE)
+#define NEXT_BLKP(bp)       ((char *) (bp) + GET_SIZE((char *) (bp) - WSIZE))
+#define PREV_BLKP(bp)       ((char *) (bp) - GET_SIZE((char *) (bp) - DSIZE))
+
+/* Whether the block before bp is free, from its footer or from bp's header */
+#define BLOCK_PREV_FREE(bp) (BLOCK_LAYOUT == LAYOUT_TAGS ? !GET_ALLOC((char *) (bp) - DSIZE) \
+				: !GET_PREV_ALLOC(HDRP(bp)))
+
+/*
+ * The links of a free block, at the start of its payload. A link is a
+ * pointer unless the allocator sets LINK_SIZE, GET_LINK and PUT_LINK.
+ */
+#ifndef LINK_SIZE
+#define LINK_SIZE           DSIZE
+#define GET_LINK(p)         ((char *) GET(p))
+#define PUT_LINK(p, bp)     PUT(p, (size_t) (bp))
+#endif
+#define NEXT_FREE(bp)       ((char *) (bp))
+#define PREV_FREE(bp)       ((char *) (bp) + LINK_SIZE)
+#define GET_NEXT_FREE(bp)   GET_LINK(NEXT_FREE(bp))
+#define GET_PREV_FREE(bp)   GET_LINK(PREV_FREE(bp))
+
+/*header, footer and the two links*/
+#define MIN_BLOCK_SIZE      (2 * WSIZE + 2 * LINK_SIZE)
+
+/*
+ * A large block starts MMAP_HDR_SIZE bytes or more into a mapping of its
+ * own: the word before its header holds the length of the mapping, the
+ * 4 bytes before the header the offset of the payload in it. Its header
+ * is PACK(0, MMAPPED | ALLOC).
+ */
+#define MMAP_HDR_SIZE       (2 * DSIZE)
+#define MMAP_LEN(bp)        GET((char *) (bp) - MMAP_HDR_SIZE)
+#define MMAP_LEAD(bp)       GET_4((char *) (bp) - DSIZE)
+
+/*
+ * The segregated lists. List i holds the free blocks of size
+ * (LIST_LIMIT(i-1), LIST_LIMIT(i)], i.e. the lists are powers of two
+ * from 128 bytes up, and the last list holds everything larger. An
+ * allocator may put EXACT_LISTS lists of a single size in front, one
+ * per DSIZE bytes from MIN_BLOCK_SIZE.
+ */
+#ifndef EXACT_LISTS
+#define EXACT_LISTS         0
+#endif
+#define SEG_LISTS           (12 + EXACT_LISTS)
+#define LIST0_SHIFT         7 /*the first list after EXACT_LISTS holds every block up to 128 bytes*/
+#define LIST_LIMIT(i)       ((size_t) 1 << (LIST0_SHIFT + (i) - EXACT_LISTS))
+
+/*
+ * seg_index - The segregated list of a block of asize bytes, i.e.
+ * ceil(log2(asize)) - 7 (plus EXACT_LISTS) clamped to [EXACT_LISTS,
+ * SEG_LISTS - 1], computed with count leading zeros, or the list of its
+ * exact size
+ */
+static inline size_t seg_index(size_t asize){
+	size_t index;
+
+	if (asize < MIN_BLOCK_SIZE + EXACT_LISTS * DSIZE)
+		return (asize - MIN_BLOCK_SIZE) / DSIZE;
+	if (asize <= LIST_LIMIT(EXACT_LISTS))
+		return EXACT_LISTS;
+	index = (8 * sizeof(size_t) - __builtin_clzl(asize - 1)) - LIST0_SHIFT + EXACT_LISTS;
+	return MIN(index, SEG_LISTS - 1);
+}
+#endif /* __MM_BLOCK_H__ */
+
+/*
+ * The template
+ * ------------
+ */
+#ifdef BLOCK_STATS
+#ifndef BLOCK
+#define BLOCK(name)         block_##name
+#endif
+#ifndef BLOCK_LAYOUT
+#define BLOCK_LAYOUT        LAYOUT_PREV
+#endif
+#ifndef BLOCK_HEAP
+#define BLOCK_HEAP
+#define BLOCK_HEAP_ARG
+#endif
+#ifndef BLOCK_MERGED
+#define BLOCK_MERGED(bp, size)
+#endif
+#ifndef BLOCK_LOAD_HDR
+#define BLOCK_LOAD_HDR(bp)  GET_4(HDRP(bp))
+#define BLOCK_STORE_HDR(bp, val) PUT_4(HDRP(bp), val)
+#endif
+
+/*
+ * BLOCK(set_alloc) - Make bp an allocated block of size bytes and tell
+ * the block after it. The prev allocated bit in bp's header is kept.
+ */
+static inline void BLOCK(set_alloc)(char *bp, size_t size){
+	if (BLOCK_LAYOUT == LAYOUT_TAGS){
+		PUT_4(HDRP(bp), PACK(size, ALLOC));
+		PUT_4(FTRP(bp), PACK(size, ALLOC));
+	}
+	else{
+		PUT_4(HDRP(bp), PACK(size, GET_PREV_ALLOC(HDRP(bp)) | ALLOC));
+		BLOCK_STORE_HDR(NEXT_BLKP(bp), BLOCK_LOAD_HDR(NEXT_BLKP(bp)) | PREV_ALLOC);
+	}
+}
+
+/*
+ * BLOCK(set_free) - Make bp a free block of size bytes, on no list yet,
+ * and tell the block after it. The prev allocated bit in bp's header is kept.
+ */
+static inline void BLOCK(set_free)(char *bp, size_t size){
+	PUT_4(HDRP(bp), PACK(size, BLOCK_LAYOUT == LAYOUT_PREV ? GET_PREV_ALLOC(HDRP(bp)) : 0));
+	PUT_4(FTRP(bp), GET_4(HDRP(bp)));
+	if (BLOCK_LAYOUT == LAYOUT_PREV){
+		BLOCK_STORE_HDR(NEXT_BLKP(bp), BLOCK_LOAD_HDR(NEXT_BLKP(bp)) & ~PREV_ALLOC);
+	}
+}
+
+#ifdef LIST_HEAD
+#ifndef LIST_INDEX
+#define LIST_INDEX(size)    seg_index(size)
+#define LIST_MARK(i)        (LIST_BITMAP |= (size_t) 1 << (i))
+#define LIST_UNMARK(i)      (LIST_BITMAP &= ~((size_t) 1 << (i)))
+#endif
+#ifndef BLOCK_ADD
+#define BLOCK_ADD(bp, size) BLOCK(add_free)(BLOCK_HEAP_ARG bp, size)
+#define BLOCK_REM(bp, size) BLOCK(rem_free)(BLOCK_HEAP_ARG bp, size)
+#endif
+
+/*
+ * BLOCK(add_free) - Put the free block bp of size bytes on its list,
+ * first, or last if the lists have tails
+ */
+static inline void BLOCK(add_free)(BLOCK_HEAP char *bp, size_t size){
+	size_t i = LIST_INDEX(size);
+	char *head = LIST_HEAD(i);
+
+	BLOCK_STATS.class_bytes[MM_SIZE_CLASS(size)] += size;
+	BLOCK_STATS.class_blocks[MM_SIZE_CLASS(size)]++;
+#ifdef LIST_TAIL
+	if (head != NULL){
+		PUT_LINK(NEXT_FREE(bp), NULL);
+		PUT_LINK(PREV_FREE(bp), LIST_TAIL(i));
+		PUT_LINK(NEXT_FREE(LIST_TAIL(i)), bp);
+		LIST_TAIL(i) = bp;
+		return;
+	}
+	LIST_TAIL(i) = bp;
+#endif
+	PUT_LINK(NEXT_FREE(bp), head);
+	PUT_LINK(PREV_FREE(bp), NULL);
+	if (head != NULL){
+		PUT_LINK(PREV_FREE(head), bp);
+	}
+	else{
+		LIST_MARK(i); /*list is not empty any more*/
+	}
+	LIST_HEAD(i) = bp;
+}
+
+/*
+ * BLOCK(rem_free) - Take the free block bp of size bytes off its list
+ */
+static inline void BLOCK(rem_free)(BLOCK_HEAP char *bp, size_t size){
+	size_t i = LIST_INDEX(size);
+	char *next = GET_NEXT_FREE(bp);
+	char *prev = GET_PREV_FREE(bp);
+
+	BLOCK_STATS.class_bytes[MM_SIZE_CLASS(size)] -= size;
+	BLOCK_STATS.class_blocks[MM_SIZE_CLASS(size)]--;
+	if (prev != NULL){
+		PUT_LINK(NEXT_FREE(prev), next);
+	}
+	else if ((LIST_HEAD(i) = next) == NULL){
+		LIST_UNMARK(i); /*and the list is empty*/
+	}
+	if (next != NULL){
+		PUT_LINK(PREV_FREE(next), prev);
+	}
+#ifdef LIST_TAIL
+	else{
+		LIST_TAIL(i) = prev;
+	}
+#endif
+}
+
+/*
+ * BLOCK(find_in_list) - First block of list i of at least asize bytes,
+ * or NULL
+ */
+static inline char *BLOCK(find_in_list)(BLOCK_HEAP size_t i, size_t asize){
+	char *bp;
+
+	for (bp = LIST_HEAD(i); bp != NULL && GET_SIZE(HDRP(bp)) < asize; bp = GET_NEXT_FREE(bp))
+		;
+	return bp;
+}
+
+#ifdef LIST_BITMAP
+/*
+ * BLOCK(find_fit) - A free block of at least asize bytes, or NULL. Only
+ * the list asize maps to needs a search, any block in a larger non-empty
+ * list fits, so we take the head of the first one, found with a single
+ * ctz on the bitmap of non-empty lists.
+ */
+static inline char *BLOCK(find_fit)(BLOCK_HEAP size_t asize){
+	size_t i = LIST_INDEX(asize);
+	size_t lists; /*non-empty lists above i*/
+	char *bp;
+
+	if (((LIST_BITMAP >> i) & 1) && (bp = BLOCK(find_in_list)(BLOCK_HEAP_ARG i, asize)) != NULL){
+		return bp;
+	}
+	lists = LIST_BITMAP & ~(((size_t) 2 << i) - 1);
+	return lists != 0 ? LIST_HEAD(__builtin_ctzl(lists)) : NULL;
+}
+#endif
+#endif /* LIST_HEAD */
+
+/*
+ * BLOCK(coalesce) - Merge the free block bp, made by set_free and on no
+ * list yet, with the free blocks next to it, and put the result on its
+ * list. Returns the merged block.
+ */
+static inline char *BLOCK(coalesce)(BLOCK_HEAP char *bp){
+	size_t size = GET_SIZE(HDRP(bp));
+	char *next = NEXT_BLKP(bp);
+	int merged = 0;
+
+	if (!GET_ALLOC(HDRP(next))){
+		BLOCK_REM(next, GET_SIZE(HDRP(next)));
+		size += GET_SIZE(HDRP(next));
+		merged = 1;
+	}
+	if (BLOCK_PREV_FREE(bp)){
+		bp = PREV_BLKP(bp);
+		BLOCK_REM(bp, GET_SIZE(HDRP(bp)));
+		size += GET_SIZE(HDRP(bp));
+		merged = 1;
+	}
+	if (merged){ /*the block after it already knows a free block is before it*/
+		PUT_4(HDRP(bp), PACK(size, BLOCK_LAYOUT == LAYOUT_PREV ? GET_PREV_ALLOC(HDRP(bp)) : 0));
+		PUT_4(FTRP(bp), GET_4(HDRP(bp)));
+		BLOCK_STATS.coalesces++;
+	}
+	BLOCK_ADD(bp, size);
+	if (merged){
+		BLOCK_MERGED(bp, size);
+	}
+	return bp;
+}
+
+/*
+ * BLOCK(place) - Allocate asize bytes at the start of the free block bp,
+ * on its list, and give the rest back as a free block if it is big
+ * enough to be one
+ */
+static inline void BLOCK(place)(BLOCK_HEAP char *bp, size_t asize){
+	size_t size = GET_SIZE(HDRP(bp));
+
+	BLOCK_REM(bp, size);
+	if (size - asize >= MIN_BLOCK_SIZE){
+		BLOCK(set_alloc)(bp, asize);
+		BLOCK(set_free)(NEXT_BLKP(bp), size - asize);
+		BLOCK_ADD(NEXT_BLKP(bp), size - asize);
+		BLOCK_STATS.splits++;
+	}
+	else{
+		BLOCK(set_alloc)(bp, size);
+	}
+}
+
+/*
+ * BLOCK(shrink) - Cut the allocated block bp down to asize bytes if the
+ * rest is big enough to be a block, and free the rest
+ */
+static inline void BLOCK(shrink)(BLOCK_HEAP char *bp, size_t asize){
+	size_t size = GET_SIZE(HDRP(bp));
+
+	if (size - asize < MIN_BLOCK_SIZE){
+		return; /*not worth a block of its own*/
+	}
+	BLOCK(set_alloc)(bp, asize);
+	BLOCK(set_free)(NEXT_BLKP(bp), size - asize);
+	BLOCK_STATS.splits++;
+	BLOCK(coalesce)(BLOCK_HEAP_ARG NEXT_BLKP(bp));
+}
+
+/*
+ * BLOCK(extend) - Grow the heap by size bytes, a multiple of DSIZE, as
+ * a free block merged with a free last block. Returns the merged block,
+ * on its list, or NULL if mem_sbrk fails or size is more than a header
+ * holds.
+ */
+static inline char *BLOCK(extend)(BLOCK_HEAP size_t size){
+	char *bp;
+
+	if (size > INT_MAX || (bp = mem_sbrk(size)) == (void *) -1){
+		return NULL;
+	}
+	/*the old epilogue is the new block's header*/
+	PUT_4(HDRP(bp), PACK(size, BLOCK_LAYOUT == LAYOUT_PREV ? GET_PREV_ALLOC(HDRP(bp)) : 0));
+	PUT_4(FTRP(bp), GET_4(HDRP(bp)));
+	PUT_4(HDRP(NEXT_BLKP(bp)), PACK(0, ALLOC)); /*new epilogue*/
+	BLOCK_STATS.extends++;
+	BLOCK_STATS.peak_heap = MAX(BLOCK_STATS.peak_heap, mem_heapsize());
+	return BLOCK(coalesce)(BLOCK_HEAP_ARG bp);
+}
+
+#ifdef BLOCK_MAPPED
+/*
+ * BLOCK(map) - A large block of size bytes aligned to align bytes, or
+ * NULL. Mappings are page aligned, so up to a page the payload just
+ * starts further in; beyond that we map align bytes more and look for an
+ * aligned payload in them. The mapped counters are atomic, any thread
+ * may unmap a block.
+ */
+static inline char *BLOCK(map)(size_t align, size_t size){
+	size_t page = mem_pagesize();
+	size_t lead; /*most bytes in front of the payload*/
+	size_t len;
+	char *region, *bp;
+
+	lead = align > page ? MMAP_HDR_SIZE + align : (MMAP_HDR_SIZE + align - 1) & ~(align - 1);
+	if (size > ~(size_t) 0 - lead - page){
+		return NULL; /*length would overflow*/
+	}
+	len = (size + lead + page - 1) & ~(page - 1);
+	if ((region = mem_map(len)) == NULL){
+		return NULL;
+	}
+	bp = (char *) (((size_t) region + MMAP_HDR_SIZE + align - 1) & ~(align - 1));
+	MMAP_LEN(bp) = len;
+	MMAP_LEAD(bp) = bp - region;
+	PUT_4(HDRP(bp), PACK(0, MMAPPED | ALLOC));
+	__atomic_add_fetch(&BLOCK_MAPPED.mapped_bytes, len, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&BLOCK_MAPPED.mapped_blocks, 1, __ATOMIC_RELAXED);
+	return bp;
+}
+
+/*
+ * BLOCK(unmap) - Unmap the mapping of the large block bp
+ */
+static inline void BLOCK(unmap)(char *bp){
+	__atomic_sub_fetch(&BLOCK_MAPPED.mapped_bytes, MMAP_LEN(bp), __ATOMIC_RELAXED);
+	__atomic_sub_fetch(&BLOCK_MAPPED.mapped_blocks, 1, __ATOMIC_RELAXED);
+	mem_unmap(bp - MMAP_LEAD(bp), MMAP_LEN(bp));
+}
+
+/*
+ * BLOCK(remap) - Resize the large block bp to size bytes with mem_remap,
+ * which moves pages instead of copying bytes. Returns the block, or NULL
+ * with bp left as it was.
+ */
+static inline char *BLOCK(remap)(char *bp, size_t size){
+	size_t page = mem_pagesize();
+	size_t oldlen = MMAP_LEN(bp);
+	size_t lead = MMAP_LEAD(bp); /*stays the same in the new mapping*/
+	size_t len;
+	char *region;
+
+	if (size > ~(size_t) 0 - lead - page){
+		return NULL;
+	}
+	len = (size + lead + page - 1) & ~(page - 1);
+	if (len == oldlen){
+		return bp;
+	}
+	if ((region = mem_remap(bp - lead, oldlen, len)) == NULL){
+		return NULL;
+	}
+	MMAP_LEN(region + lead) = len;
+	__atomic_add_fetch(&BLOCK_MAPPED.mapped_bytes, len - oldlen, __ATOMIC_RELAXED);
+	return region + lead;
+}
+#endif /* BLOCK_MAPPED */
+#endif /* BLOCK_STATS */
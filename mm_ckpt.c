@@ -0,0 +1,11 @@
+/*
+ * mm_ckpt.c - Builds the explicit free list allocator (malloc_checkpoint.c)
+ * for the benchmark driver under its own set of names
+ */
+#define DRIVER
+#define MM_PREFIX    ckpt_
+#define MM_LABEL     "explicit"
+#define MM_SOURCE    "malloc_checkpoint.c"
+#define MM_BASIC
+
+#include "mm_wrap.h"
@@ -0,0 +1,14 @@
+/*
+ * mm_ckpt_tree.c - Builds the explicit allocator (malloc_checkpoint.c)
+ * with its free tree (-DFREE_TREE) for the benchmark driver
+ */
+#define DRIVER
+#define FREE_TREE
+#define MM_PREFIX    ckpt_tree_
+#define MM_LABEL     "explicit-tree"
+#define MM_SOURCE    "malloc_checkpoint.c"
+#define MM_BASIC
+/*and the helper malloc_checkpoint.c leaves global, which mm_ckpt.c has too*/
+#define print_list   ckpt_tree_print_list
+
+#include "mm_wrap.h"
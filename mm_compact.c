@@ -0,0 +1,11 @@
+/*
+ * mm_compact.c - Builds the segregated list allocator (malloc_lab.c) with
+ * 4 byte free list links and 16 byte minimum blocks (-DMM_COMPACT) for
+ * the benchmark driver
+ */
+#define DRIVER
+#define MM_COMPACT
+#define MM_PREFIX    compact_
+#define MM_LABEL     "seglist-compact"
+
+#include "mm_wrap.h"
@@ -0,0 +1,393 @@
+/*
+ * mm_core.c - Matrix core: a boundary tag allocator written once for
+ * every choice of free block index, fit and block layout
+ *
+ * malloc_lab.c and malloc_checkpoint.c share their blocks (mm_block.h)
+ * and differ mostly in how free blocks are found. This file builds an
+ * allocator on those same blocks with everything but the policies
+ * stripped away, so they can be compared on their own in the driver's
+ * matrix (mdriver -M); a change to the blocks is seen here as in both
+ * allocators. It is a template: mm_cores.c includes it once per
+ * configuration, with
+ *   CORE(name)   pasting a prefix of its own onto every name defined here
+ *   CORE_NAME    the name the driver prints
+ *   CORE_INDEX   INDEX_SEG, malloc_lab.c's SEG_LISTS segregated lists with a
+ *                bitmap of the non-empty ones, a freed block going first
+ *                (LIFO), or INDEX_LIST, malloc_checkpoint.c's one list, a
+ *                freed block going last (FIFO)
+ *   CORE_FIT     FIT_FIRST, the first block big enough, FIT_BEST, the
+ *                smallest (in the first segregated list holding one, which
+ *                has all blocks smaller than the lists after it), or
+ *                FIT_GOOD, the smallest of the first GOOD_FITS that fit
+ *   CORE_LAYOUT  LAYOUT_TAGS, a header and footer on every block, or
+ *                LAYOUT_PREV, a footer on free blocks only and a bit in
+ *                each header telling whether the block before is allocated
+ * The policies are compile time constants tested with plain if statements,
+ * so each configuration compiles down to its own code with the other
+ * branches gone.
+ *
+ * The heap is a padding word, a prologue block of DSIZE bytes, the blocks,
+ * and an epilogue header of size 0. Requests never get mappings of their
+ * own and the heap never shrinks.
+ */
+#ifndef MM_CORE_COMMON
+#define MM_CORE_COMMON
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "mm_block.h"
+
+#define INDEX_SEG    0
+#define INDEX_LIST   1
+#define FIT_FIRST    0
+#define FIT_BEST     1
+#define FIT_GOOD     2
+
+#define CHUNKSIZE   (1 << 12) /*extend heap by at least this amount in bytes*/
+#define GOOD_FITS   8  /*blocks that fit a good fit looks at*/
+
+/*number of lists of the index*/
+#define CORE_LISTS           (CORE_INDEX == INDEX_SEG ? SEG_LISTS : 1)
+/*bytes an allocated block spends besides its payload*/
+#define CORE_OVERHEAD        (CORE_LAYOUT == LAYOUT_TAGS ? DSIZE : WSIZE)
+#endif /* MM_CORE_COMMON */
+
+static char *CORE(heap_start);               /*prologue block*/
+static char *CORE(heads)[SEG_LISTS];         /*first block of each list*/
+static char *CORE(tail);                     /*last block of the one list of INDEX_LIST*/
+static size_t CORE(nonempty);                /*bit i set iff list i is not empty*/
+static struct mm_heap_stats CORE(heap_stats);
+
+/*
+ * CORE(list_of) - The list a free block of size bytes goes on
+ */
+static inline size_t CORE(list_of)(size_t size){
+	return CORE_INDEX == INDEX_LIST ? 0 : seg_index(size);
+}
+
+/*
+ * The functions on blocks of mm_block.h, CORE(block_place) and so on,
+ * on the lists of the index
+ */
+#define BLOCK(name)         CORE(block_##name)
+#define BLOCK_LAYOUT        CORE_LAYOUT
+#define BLOCK_STATS         CORE(heap_stats)
+#define LIST_HEAD(i)        CORE(heads)[i]
+#define LIST_INDEX(size)    CORE(list_of)(size)
+#define LIST_MARK(i)        (CORE(nonempty) |= (size_t) 1 << (i))
+#define LIST_UNMARK(i)      (CORE(nonempty) &= ~((size_t) 1 << (i)))
+#if CORE_INDEX == INDEX_LIST
+#define LIST_TAIL(i)        CORE(tail)
+#endif
+#include "mm_block.h"
+
+/*
+ * CORE(search) - The block of the list from bp the fit policy picks for
+ * asize bytes, or NULL if none is big enough
+ */
+static inline char *CORE(search)(char *bp, size_t asize){
+	char *best = NULL;
+	size_t size, best_size = (size_t) -1;
+	int fits = 0;
+
+	for (; bp != NULL; bp = GET_NEXT_FREE(bp)){
+		size = GET_SIZE(HDRP(bp));
+		if (size < asize){
+			continue;
+		}
+		if (CORE_FIT == FIT_FIRST || size == asize){
+			return bp;
+		}
+		if (size < best_size){
+			best = bp;
+			best_size = size;
+		}
+		if (CORE_FIT == FIT_GOOD && ++fits == GOOD_FITS){
+			break;
+		}
+	}
+	return best;
+}
+
+/*
+ * CORE(find_fit) - A free block of at least asize bytes, or NULL. The
+ * segregated lists are searched from the one of asize up, skipping the
+ * empty ones, until one has a block that fits.
+ */
+static char *CORE(find_fit)(size_t asize){
+	size_t lists = CORE(nonempty) >> CORE(list_of)(asize) << CORE(list_of)(asize);
+	char *bp;
+
+	for (; lists != 0; lists &= lists - 1){
+		if ((bp = CORE(search)(CORE(heads)[__builtin_ctzl(lists)], asize)) != NULL){
+			return bp;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * CORE(adjust) - Block size for a request of size bytes
+ */
+static inline size_t CORE(adjust)(size_t size){
+	size_t asize = (size + CORE_OVERHEAD + DSIZE - 1) & ~(size_t) (DSIZE - 1);
+
+	return MAX(asize, MIN_BLOCK_SIZE);
+}
+
+static int CORE(init)(void){
+	size_t i;
+
+	memset(&CORE(heap_stats), 0, sizeof(CORE(heap_stats)));
+	for (i = 0; i < SEG_LISTS; i++){
+		CORE(heads)[i] = NULL;
+	}
+	CORE(tail) = NULL;
+	CORE(nonempty) = 0;
+	if ((CORE(heap_start) = mem_sbrk(4 * WSIZE)) == (void *) -1){
+		return -1;
+	}
+	PUT_4(CORE(heap_start), 0); /*padding*/
+	PUT_4(CORE(heap_start) + WSIZE, PACK(DSIZE, ALLOC)); /*prologue header*/
+	PUT_4(CORE(heap_start) + 2 * WSIZE, PACK(DSIZE, ALLOC)); /*prologue footer*/
+	PUT_4(CORE(heap_start) + 3 * WSIZE, PACK(0, PREV_ALLOC | ALLOC)); /*epilogue*/
+	CORE(heap_start) += DSIZE;
+	if (CORE(block_extend)(CHUNKSIZE) == NULL){
+		return -1;
+	}
+	return 0;
+}
+
+static void *CORE(malloc)(size_t size){
+	size_t asize;
+	char *bp, *last;
+
+	if (size == 0 || size > (size_t) INT32_MAX - 2 * DSIZE){
+		return NULL;
+	}
+	asize = CORE(adjust)(size);
+	if ((bp = CORE(find_fit)(asize)) == NULL){
+		/*grow the heap by what a free last block is short of*/
+		last = (char *) mem_heap_hi() + 1;
+		size = BLOCK_PREV_FREE(last) ? asize - GET_SIZE(last - DSIZE) : asize;
+		if ((bp = CORE(block_extend)(MAX(size, CHUNKSIZE))) == NULL){
+			return NULL;
+		}
+	}
+	CORE(block_place)(bp, asize);
+	return bp;
+}
+
+static void CORE(free)(void *bp){
+	if (bp == NULL){
+		return;
+	}
+	CORE(block_set_free)(bp, GET_SIZE(HDRP(bp)));
+	CORE(block_coalesce)(bp);
+}
+
+static void *CORE(realloc)(void *ptr, size_t size){
+	size_t asize, have, more;
+	char *next, *newptr;
+
+	if (ptr == NULL){
+		return CORE(malloc)(size);
+	}
+	if (size == 0){
+		CORE(free)(ptr);
+		return NULL;
+	}
+	if (size > (size_t) INT32_MAX - 2 * DSIZE){
+		return NULL;
+	}
+	asize = CORE(adjust)(size);
+	have = GET_SIZE(HDRP(ptr));
+	if (asize <= have){
+		CORE(block_shrink)(ptr, asize);
+		return ptr;
+	}
+	next = NEXT_BLKP(ptr);
+	more = GET_ALLOC(HDRP(next)) ? 0 : GET_SIZE(HDRP(next));
+	if (have + more >= asize){ /*grow into the free block after it*/
+		CORE(block_rem_free)(next, more);
+		CORE(block_set_alloc)(ptr, have + more);
+		CORE(block_shrink)(ptr, asize);
+		return ptr;
+	}
+	if ((newptr = CORE(malloc)(size)) == NULL){
+		return NULL;
+	}
+	memcpy(newptr, ptr, have - CORE_OVERHEAD);
+	CORE(free)(ptr);
+	return newptr;
+}
+
+static void *CORE(calloc)(size_t nmemb, size_t size){
+	size_t bytes;
+	void *bp;
+
+	if (__builtin_mul_overflow(nmemb, size, &bytes) || (bp = CORE(malloc)(bytes)) == NULL){
+		return NULL;
+	}
+	memset(bp, 0, bytes);
+	return bp;
+}
+
+/*
+ * CORE(memalign) - A block of size bytes aligned to align, cut out of a
+ * block big enough to hold one, with the slack in front given back
+ */
+static void *CORE(memalign)(size_t align, size_t size){
+	char *bp, *abp;
+	size_t total, lead;
+
+	if (align <= DSIZE){
+		return CORE(malloc)(size);
+	}
+	if (size > (size_t) INT32_MAX / 2 || align > (size_t) INT32_MAX / 4
+	    || (bp = CORE(malloc)(size + align + MIN_BLOCK_SIZE)) == NULL){
+		return NULL;
+	}
+	abp = bp;
+	if ((size_t) bp % align != 0){
+		abp = (char *) (((size_t) bp + MIN_BLOCK_SIZE + align - 1) & ~(align - 1));
+		total = GET_SIZE(HDRP(bp));
+		lead = abp - bp;
+		PUT_4(HDRP(abp), PACK(total - lead, ALLOC)); /*set_alloc keeps the prev allocated bit*/
+		CORE(block_set_alloc)(abp, total - lead);
+		CORE(block_set_free)(bp, lead);
+		CORE(heap_stats).splits++;
+		CORE(block_coalesce)(bp);
+	}
+	CORE(block_shrink)(abp, CORE(adjust)(size));
+	return abp;
+}
+
+static size_t CORE(usable_size)(void *bp){
+	return bp != NULL ? GET_SIZE(HDRP(bp)) - CORE_OVERHEAD : 0;
+}
+
+static void CORE(stats)(struct mm_heap_stats *st){
+	size_t i;
+
+	*st = CORE(heap_stats);
+	st->heap_size = mem_heapsize();
+	for (i = 0; i < MM_SIZE_CLASSES; i++){
+		st->free_bytes += st->class_bytes[i];
+		st->free_blocks += st->class_blocks[i];
+	}
+	st->alloc_bytes = st->heap_size - 4 * WSIZE - st->free_bytes;
+}
+
+static void CORE(heap_walk)(void (*visit)(void *arg, void *bp, size_t size, int alloc), void *arg){
+	char *bp;
+
+	for (bp = NEXT_BLKP(CORE(heap_start)); GET_SIZE(HDRP(bp)) != 0; bp = NEXT_BLKP(bp)){
+		visit(arg, bp, GET_SIZE(HDRP(bp)), GET_ALLOC(HDRP(bp)) != 0);
+	}
+}
+
+/*
+ * CORE(checkheap) - Check every block's tags against its neighbours and
+ * every list's links, that each free block is on the right list exactly
+ * once, and the counters of mm_stats. Returns 0, or 1 on an error.
+ */
+static int CORE(checkheap)(int verbose){
+	size_t bytes[MM_SIZE_CLASSES] = {0}, blocks[MM_SIZE_CLASSES] = {0};
+	size_t i, free_blocks = 0, listed = 0, size;
+	int prev_free = 0;
+	char *bp, *prev;
+
+	for (bp = NEXT_BLKP(CORE(heap_start)); (size = GET_SIZE(HDRP(bp))) != 0; bp = NEXT_BLKP(bp)){
+		if (verbose){
+			printf("%p: %lu bytes %s\n", bp, (unsigned long) size, GET_ALLOC(HDRP(bp)) ? "allocated" : "free");
+		}
+		if ((size_t) bp % DSIZE != 0 || size < MIN_BLOCK_SIZE || size % DSIZE != 0){
+			printf("Block %p is misaligned or has a bad size of %lu\n", bp, (unsigned long) size);
+			return 1;
+		}
+		if ((CORE_LAYOUT == LAYOUT_TAGS || !GET_ALLOC(HDRP(bp))) && GET_4(HDRP(bp)) != GET_4(FTRP(bp))){
+			printf("Block %p: header and footer mismatch\n", bp);
+			return 1;
+		}
+		if (CORE_LAYOUT == LAYOUT_PREV && (GET_PREV_ALLOC(HDRP(bp)) == 0) != prev_free){
+			printf("Block %p has a wrong prev allocated bit\n", bp);
+			return 1;
+		}
+		if (!GET_ALLOC(HDRP(bp))){
+			if (prev_free){
+				printf("Free blocks before %p are not coalesced\n", bp);
+				return 1;
+			}
+			bytes[MM_SIZE_CLASS(size)] += size;
+			blocks[MM_SIZE_CLASS(size)]++;
+			free_blocks++;
+		}
+		prev_free = !GET_ALLOC(HDRP(bp));
+	}
+	if (!GET_ALLOC(HDRP(bp)) || (CORE_LAYOUT == LAYOUT_PREV && (GET_PREV_ALLOC(HDRP(bp)) == 0) != prev_free)){
+		printf("Bad epilogue header\n");
+		return 1;
+	}
+	for (i = 0; i < CORE_LISTS; i++){
+		if ((CORE(heads)[i] != NULL) != ((CORE(nonempty) >> i) & 1)){
+			printf("The bitmap bit of list %lu does not match the list\n", (unsigned long) i);
+			return 1;
+		}
+		for (prev = NULL, bp = CORE(heads)[i]; bp != NULL; prev = bp, bp = GET_NEXT_FREE(bp)){
+			if (++listed > free_blocks || GET_ALLOC(HDRP(bp)) || GET_PREV_FREE(bp) != prev
+			    || CORE(list_of)(GET_SIZE(HDRP(bp))) != i){
+				printf("Free block %p is allocated, linked wrong or on the wrong list\n", bp);
+				return 1;
+			}
+		}
+		if (CORE_INDEX == INDEX_LIST && prev != CORE(tail)){
+			printf("The tail of the list is not its last block\n");
+			return 1;
+		}
+	}
+	if (listed != free_blocks){
+		printf("%lu free blocks in the heap, %lu on the lists\n",
+			(unsigned long) free_blocks, (unsigned long) listed);
+		return 1;
+	}
+	for (i = 0; i < MM_SIZE_CLASSES; i++){
+		if (bytes[i] != CORE(heap_stats).class_bytes[i] || blocks[i] != CORE(heap_stats).class_blocks[i]){
+			printf("Error: size class %lu has %lu free blocks of %lu bytes, the counters say %lu of %lu\n",
+				(unsigned long) i, (unsigned long) blocks[i], (unsigned long) bytes[i],
+				(unsigned long) CORE(heap_stats).class_blocks[i],
+				(unsigned long) CORE(heap_stats).class_bytes[i]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static const struct mm_ops CORE(mm_ops) = {
+	CORE_NAME, CORE(init), CORE(malloc), CORE(free), CORE(realloc), CORE(calloc), CORE(memalign),
+	CORE(checkheap), NULL, NULL, NULL, CORE(stats), CORE(usable_size), CORE(heap_walk), NULL
+};
+
+#undef BLOCK
+#undef BLOCK_LAYOUT
+#undef BLOCK_STATS
+#undef BLOCK_HEAP
+#undef BLOCK_HEAP_ARG
+#undef BLOCK_ADD
+#undef BLOCK_REM
+#undef BLOCK_MERGED
+#undef BLOCK_LOAD_HDR
+#undef BLOCK_STORE_HDR
+#undef LIST_HEAD
+#undef LIST_INDEX
+#undef LIST_MARK
+#undef LIST_UNMARK
+#undef LIST_TAIL
+#undef CORE
+#undef CORE_NAME
+#undef CORE_INDEX
+#undef CORE_FIT
+#undef CORE_LAYOUT
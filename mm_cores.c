@@ -0,0 +1,96 @@
+/*
+ * mm_cores.c - Builds mm_core.c once for every free block index, fit and
+ * block layout, for the benchmark driver's matrix (mdriver -M)
+ */
+#define CORE(name)  seg_first_tags_##name
+#define CORE_NAME   "seg-first-tags"
+#define CORE_INDEX  INDEX_SEG
+#define CORE_FIT    FIT_FIRST
+#define CORE_LAYOUT LAYOUT_TAGS
+#include "mm_core.c"
+
+#define CORE(name)  seg_first_prev_##name
+#define CORE_NAME   "seg-first-prev"
+#define CORE_INDEX  INDEX_SEG
+#define CORE_FIT    FIT_FIRST
+#define CORE_LAYOUT LAYOUT_PREV
+#include "mm_core.c"
+
+#define CORE(name)  seg_best_tags_##name
+#define CORE_NAME   "seg-best-tags"
+#define CORE_INDEX  INDEX_SEG
+#define CORE_FIT    FIT_BEST
+#define CORE_LAYOUT LAYOUT_TAGS
+#include "mm_core.c"
+
+#define CORE(name)  seg_best_prev_##name
+#define CORE_NAME   "seg-best-prev"
+#define CORE_INDEX  INDEX_SEG
+#define CORE_FIT    FIT_BEST
+#define CORE_LAYOUT LAYOUT_PREV
+#include "mm_core.c"
+
+#define CORE(name)  seg_good_tags_##name
+#define CORE_NAME   "seg-good-tags"
+#define CORE_INDEX  INDEX_SEG
+#define CORE_FIT    FIT_GOOD
+#define CORE_LAYOUT LAYOUT_TAGS
+#include "mm_core.c"
+
+#define CORE(name)  seg_good_prev_##name
+#define CORE_NAME   "seg-good-prev"
+#define CORE_INDEX  INDEX_SEG
+#define CORE_FIT    FIT_GOOD
+#define CORE_LAYOUT LAYOUT_PREV
+#include "mm_core.c"
+
+#define CORE(name)  list_first_tags_##name
+#define CORE_NAME   "list-first-tags"
+#define CORE_INDEX  INDEX_LIST
+#define CORE_FIT    FIT_FIRST
+#define CORE_LAYOUT LAYOUT_TAGS
+#include "mm_core.c"
+
+#define CORE(name)  list_first_prev_##name
+#define CORE_NAME   "list-first-prev"
+#define CORE_INDEX  INDEX_LIST
+#define CORE_FIT    FIT_FIRST
+#define CORE_LAYOUT LAYOUT_PREV
+#include "mm_core.c"
+
+#define CORE(name)  list_best_tags_##name
+#define CORE_NAME   "list-best-tags"
+#define CORE_INDEX  INDEX_LIST
+#define CORE_FIT    FIT_BEST
+#define CORE_LAYOUT LAYOUT_TAGS
+#include "mm_core.c"
+
+#define CORE(name)  list_best_prev_##name
+#define CORE_NAME   "list-best-prev"
+#define CORE_INDEX  INDEX_LIST
+#define CORE_FIT    FIT_BEST
+#define CORE_LAYOUT LAYOUT_PREV
+#include "mm_core.c"
+
+#define CORE(name)  list_good_tags_##name
+#define CORE_NAME   "list-good-tags"
+#define CORE_INDEX  INDEX_LIST
+#define CORE_FIT    FIT_GOOD
+#define CORE_LAYOUT LAYOUT_TAGS
+#include "mm_core.c"
+
+#define CORE(name)  list_good_prev_##name
+#define CORE_NAME   "list-good-prev"
+#define CORE_INDEX  INDEX_LIST
+#define CORE_FIT    FIT_GOOD
+#define CORE_LAYOUT LAYOUT_PREV
+#include "mm_core.c"
+
+const struct mm_ops *const core_mm_ops[] = {
+	&seg_first_tags_mm_ops, &seg_first_prev_mm_ops, &seg_best_tags_mm_ops,
+	&seg_best_prev_mm_ops, &seg_good_tags_mm_ops, &seg_good_prev_mm_ops,
+	&list_first_tags_mm_ops, &list_first_prev_mm_ops, &list_best_tags_mm_ops,
+	&list_best_prev_mm_ops, &list_good_tags_mm_ops, &list_good_prev_mm_ops,
+};
+
+const int num_core_mm_ops = sizeof(core_mm_ops) / sizeof(core_mm_ops[0]);
@@ -0,0 +1,11 @@
+/*
+ * mm_huge.c - Builds the segregated list allocator with a heap of
+ * transparent huge pages (malloc_lab.c with -DMM_HUGE) for the
+ * benchmark drivers
+ */
+#define DRIVER
+#define MM_HUGE
+#define MM_PREFIX    huge_
+#define MM_LABEL     "seglist-huge"
+
+#include "mm_wrap.h"
@@ -0,0 +1,196 @@
+/*
+ * mm_preload.c - Builds the thread safe segregated list allocator
+ * (malloc_lab.c with -DMM_THREADS) as a shared library that replaces
+ * the C library allocator in any dynamically linked program:
+ *
+ *   LD_PRELOAD=./libmm.so sort big.txt
+ *
+ * The allocator is built under the mm_* names as for the driver, and
+ * the standard entry points below make sure the heap is set up before
+ * passing each call on. The heap is the real thing here: memlib is
+ * built with -DMEM_UNTRACKED and a MAX_HEAP large enough for real
+ * programs (see the Makefile), and large blocks are plain mappings.
+ *
+ * The heap is set up by a constructor, or by the first call if some
+ * other library's constructor allocates before ours runs; either way
+ * that happens before the program can start threads. Around fork the
+ * heap lock is taken, so the child never inherits it held by a thread
+ * that does not exist in the child.
+ *
+ * Built with -DMM_PROFILE (libmm_prof.so) the heap profiler samples about
+ * every MM_PROFILE_RATE bytes allocated (see malloc_lab.c), and the live
+ * samples are written to the file MM_PROFILE names when the program exits:
+ *
+ *   LD_PRELOAD=./libmm_prof.so MM_PROFILE=sort.heap sort big.txt
+ *   pprof --text /usr/bin/sort sort.heap
+ *
+ * The program may also write one at any time with mm_profile_dump.
+ */
+#define DRIVER
+#define MM_THREADS
+
+#include "malloc_lab.c"
+
+#undef malloc
+#undef free
+#undef realloc
+#undef calloc
+#undef memalign
+#undef posix_memalign
+#undef aligned_alloc
+#undef malloc_usable_size
+#undef free_sized
+
+static int initialized; /*heap set up*/
+
+static void preload_init(void);
+static void prepare_fork(void);
+static void after_fork(void);
+
+#define ENSURE_INIT()   do { if (__builtin_expect(!initialized, 0)) preload_init(); } while (0)
+
+/*
+ * preload_init - Reserve the heap and build an empty one
+ */
+static void preload_init(void){
+#ifdef MM_PROFILE
+	const char *rate;
+#endif
+
+	mem_init();
+	if (mm_init() < 0){
+		fprintf(stderr, "libmm: mm_init failed\n");
+		abort();
+	}
+#ifdef MM_PROFILE
+	if ((rate = getenv("MM_PROFILE_RATE")) != NULL){
+		mm_profile_rate(strtoul(rate, NULL, 10));
+	}
+#endif
+	initialized = 1;
+	/*last, it may allocate*/
+	pthread_atfork(prepare_fork, after_fork, after_fork);
+}
+
+static void __attribute__((constructor)) preload_constructor(void){
+	ENSURE_INIT();
+}
+
+#ifdef MM_PROFILE
+static void __attribute__((destructor)) preload_destructor(void){
+	const char *path = getenv("MM_PROFILE");
+
+	if (path != NULL && mm_profile_dump(path) < 0){
+		fprintf(stderr, "libmm: cannot write the heap profile to %s\n", path);
+	}
+}
+#endif
+
+/*
+ * prepare_fork, after_fork - Hold the heap lock across fork, in
+ * the parent and the child alike
+ */
+static void prepare_fork(void){
+	pthread_mutex_lock(&heap_lock);
+}
+
+static void after_fork(void){
+	pthread_mutex_unlock(&heap_lock);
+}
+
+/*
+ * The standard entry points. Like the C library's, malloc and calloc
+ * return a block of their own for 0 bytes, which programs count on,
+ * and out of memory they all set errno.
+ */
+void *malloc(size_t size){
+	void *p;
+
+	ENSURE_INIT();
+	if ((p = mm_malloc(size ? size : 1)) == NULL){
+		errno = ENOMEM;
+	}
+	return p;
+}
+
+void free(void *ptr){
+	ENSURE_INIT();
+	mm_free(ptr);
+}
+
+void free_sized(void *ptr, size_t size){
+	ENSURE_INIT();
+	mm_free_sized(ptr, size);
+}
+
+void *realloc(void *ptr, size_t size){
+	void *p;
+
+	ENSURE_INIT();
+	if ((p = mm_realloc(ptr, size)) == NULL && size != 0){
+		errno = ENOMEM;
+	}
+	return p;
+}
+
+void *calloc(size_t nmemb, size_t size){
+	void *p;
+
+	ENSURE_INIT();
+	if (nmemb == 0 || size == 0){
+		nmemb = size = 1;
+	}
+	if ((p = mm_calloc(nmemb, size)) == NULL){
+		errno = ENOMEM;
+	}
+	return p;
+}
+
+void *memalign(size_t alignment, size_t size){
+	ENSURE_INIT();
+	return mm_memalign(alignment, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size){
+	ENSURE_INIT();
+	return mm_posix_memalign(memptr, alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size){
+	ENSURE_INIT();
+	return mm_aligned_alloc(alignment, size);
+}
+
+/*
+ * valloc, pvalloc - Page aligned blocks, pvalloc also rounds the
+ * size up to whole pages
+ */
+void *valloc(size_t size){
+	ENSURE_INIT();
+	return mm_memalign(mem_pagesize(), size);
+}
+
+void *pvalloc(size_t size){
+	size_t page = mem_pagesize();
+
+	ENSURE_INIT();
+	return mm_memalign(page, (size + page - 1) & ~(page - 1));
+}
+
+/*
+ * reallocarray - realloc of nmemb elements of size bytes, the C library
+ * one calls its own realloc directly, so it has to be replaced too
+ */
+void *reallocarray(void *ptr, size_t nmemb, size_t size){
+	if (size != 0 && nmemb > ~(size_t) 0 / size){
+		errno = ENOMEM;
+		return NULL;
+	}
+	ENSURE_INIT();
+	return mm_realloc(ptr, nmemb * size);
+}
+
+size_t malloc_usable_size(void *ptr){
+	ENSURE_INIT();
+	return mm_malloc_usable_size(ptr);
+}
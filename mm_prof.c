@@ -0,0 +1,11 @@
+/*
+ * mm_prof.c - Builds the segregated list allocator (malloc_lab.c) with
+ * the sampling heap profiler (-DMM_PROFILE) for the benchmark driver,
+ * to measure what the sampling costs
+ */
+#define DRIVER
+#define MM_PROFILE
+#define MM_PREFIX    prof_
+#define MM_LABEL     "seglist-prof"
+
+#include "mm_wrap.h"
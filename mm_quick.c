@@ -0,0 +1,10 @@
+/*
+ * mm_quick.c - Builds the segregated list allocator (malloc_lab.c) with
+ * quick lists and deferred coalescing (-DMM_QUICK) for the benchmark driver
+ */
+#define DRIVER
+#define MM_QUICK
+#define MM_PREFIX    quick_
+#define MM_LABEL     "seglist-quick"
+
+#include "mm_wrap.h"
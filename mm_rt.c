@@ -0,0 +1,12 @@
+/*
+ * mm_rt.c - Builds the segregated list allocator (malloc_lab.c) with the
+ * two level segregated fit index and bounded latency (-DTLSF -DMM_RT), on
+ * a pool made by mm_init, for the benchmark drivers
+ */
+#define DRIVER
+#define TLSF
+#define MM_RT
+#define MM_PREFIX    rt_
+#define MM_LABEL     "tlsf-rt"
+
+#include "mm_wrap.h"
@@ -0,0 +1,9 @@
+/*
+ * mm_seg.c - Builds the segregated list allocator (malloc_lab.c)
+ * for the benchmark driver under its own set of names
+ */
+#define DRIVER
+#define MM_PREFIX    seg_
+#define MM_LABEL     "seglist"
+
+#include "mm_wrap.h"
@@ -0,0 +1,10 @@
+/*
+ * mm_seg_mt.c - Builds the thread safe segregated list allocator
+ * (malloc_lab.c with -DMM_THREADS) for the benchmark drivers
+ */
+#define DRIVER
+#define MM_THREADS
+#define MM_PREFIX    seg_mt_
+#define MM_LABEL     "seglist-mt"
+
+#include "mm_wrap.h"
@@ -0,0 +1,10 @@
+/*
+ * mm_slab.c - Builds the segregated list allocator (malloc_lab.c) with
+ * the slab layer for small objects (-DMM_SLAB) for the benchmark driver
+ */
+#define DRIVER
+#define MM_SLAB
+#define MM_PREFIX    slab_
+#define MM_LABEL     "seglist-slab"
+
+#include "mm_wrap.h"
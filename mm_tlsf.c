@@ -0,0 +1,10 @@
+/*
+ * mm_tlsf.c - Builds the segregated list allocator (malloc_lab.c) with
+ * the two level segregated fit index (-DTLSF) for the benchmark driver
+ */
+#define DRIVER
+#define TLSF
+#define MM_PREFIX    tlsf_
+#define MM_LABEL     "tlsf"
+
+#include "mm_wrap.h"
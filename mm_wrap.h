@@ -0,0 +1,64 @@
+/*
+ * mm_wrap.h - Builds one allocator under its own set of names for the
+ * benchmark drivers
+ *
+ * Every allocator exports the same mm_* names, so a wrapper (mm_seg.c,
+ * mm_ckpt.c ...) sets its flags and
+ *
+ *   MM_PREFIX    prefix of its names, seg_ makes mm_malloc seg_mm_malloc
+ *   MM_LABEL     short name the drivers print
+ *   MM_SOURCE    allocator to build, "malloc_lab.c" if not set
+ *   MM_BASIC     if the allocator has no free_sized, free_many,
+ *                malloc_batch or checkheap_step
+ *
+ * and includes this file, which renames the entry points, includes the
+ * allocator and publishes it as the table <prefix>mm_ops.
+ */
+#ifndef MM_PREFIX
+#error "define MM_PREFIX before including mm_wrap.h"
+#endif
+#ifndef MM_SOURCE
+#define MM_SOURCE "malloc_lab.c"
+#endif
+
+#define MM_CAT_(a, b) a##b
+#define MM_CAT(a, b)  MM_CAT_(a, b) /*expand a and b first*/
+#define MM_WRAP(name) MM_CAT(MM_PREFIX, name)
+
+#define mm_init      MM_WRAP(mm_init)
+#define mm_malloc    MM_WRAP(mm_malloc)
+#define mm_free      MM_WRAP(mm_free)
+#define mm_realloc   MM_WRAP(mm_realloc)
+#define mm_calloc    MM_WRAP(mm_calloc)
+#define mm_memalign  MM_WRAP(mm_memalign)
+#define mm_posix_memalign MM_WRAP(mm_posix_memalign)
+#define mm_aligned_alloc MM_WRAP(mm_aligned_alloc)
+#define mm_malloc_usable_size MM_WRAP(mm_malloc_usable_size)
+#define mm_checkheap MM_WRAP(mm_checkheap)
+#define mm_checkheap_step MM_WRAP(mm_checkheap_step)
+#define mm_free_sized MM_WRAP(mm_free_sized)
+#define mm_free_many MM_WRAP(mm_free_many)
+#define mm_malloc_batch MM_WRAP(mm_malloc_batch)
+#define mm_stats     MM_WRAP(mm_stats)
+#define mm_heap_walk MM_WRAP(mm_heap_walk)
+#define mm_region_create MM_WRAP(mm_region_create)
+#define mm_region_alloc MM_WRAP(mm_region_alloc)
+#define mm_region_destroy MM_WRAP(mm_region_destroy)
+#define mm_profile_rate MM_WRAP(mm_profile_rate)
+#define mm_profile_dump MM_WRAP(mm_profile_dump)
+
+#include MM_SOURCE
+
+#ifndef MM_BASIC
+const struct mm_ops MM_WRAP(mm_ops) = {
+	MM_LABEL, mm_init, mm_malloc, mm_free, mm_realloc, mm_calloc, mm_memalign,
+	mm_checkheap, mm_free_sized, mm_free_many, mm_malloc_batch, mm_stats,
+	mm_malloc_usable_size, mm_heap_walk, mm_checkheap_step
+};
+#else
+const struct mm_ops MM_WRAP(mm_ops) = {
+	MM_LABEL, mm_init, mm_malloc, mm_free, mm_realloc, mm_calloc, mm_memalign,
+	mm_checkheap, NULL, NULL, NULL, mm_stats, mm_malloc_usable_size,
+	mm_heap_walk, NULL
+};
+#endif
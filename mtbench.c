@@ -0,0 +1,259 @@
+/*
+ * mtbench.c - Multithreaded benchmark for the thread safe allocator
+ *
+ * Every thread owns a table of slots and runs a random sequence of
+ * operations on it: an empty slot gets a new block, a full slot has
+ * its block freed. Most blocks are small, a few are large enough to
+ * bypass the thread caches. Each block gets its first and last byte
+ * written and checked, so blocks handed to two threads at once show up.
+ * The same run is repeated for 1, 2, 4 ... threads, with the lab
+ * allocator (malloc_lab.c built with -DMM_THREADS), the allocator with
+ * an arena per thread (malloc_arena.c) and the C library.
+ *
+ * With -x the threads instead work in pairs, a producer allocating blocks
+ * and handing them through a ring to a consumer that checks and frees
+ * them, so every block is freed by another thread than the one that
+ * allocated it; the pairs are run for 2, 4 ... threads.
+ *
+ * usage: mtbench [-x] [-t max threads] [-n ops per thread]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "mm.h"
+#include "memlib.h"
+
+#define SLOTS 1024 /*blocks each thread can hold at once*/
+#define RING  256  /*blocks a producer may have handed on and its consumer not freed yet*/
+
+extern const struct mm_ops seg_mt_mm_ops;
+extern const struct mm_ops arena_mm_ops;
+
+static int libc_init(void){
+	return 0;
+}
+
+static int libc_checkheap(int verbose){
+	return 0;
+}
+
+/*the C library allocator, as a baseline*/
+static const struct mm_ops libc_mm_ops = {
+	"libc", libc_init, malloc, free, realloc, calloc, aligned_alloc, libc_checkheap
+};
+
+static const struct mm_ops *allocators[] = {
+	&seg_mt_mm_ops,
+	&arena_mm_ops,
+	&libc_mm_ops,
+};
+
+#define NUM_ALLOCATORS (sizeof(allocators) / sizeof(allocators[0]))
+
+/*blocks on their way from a producer to its consumer*/
+typedef struct {
+	unsigned char *block[RING];
+	size_t size[RING];
+	unsigned long head __attribute__((aligned(64))); /*blocks produced, written by the producer*/
+	unsigned long tail __attribute__((aligned(64))); /*blocks consumed, written by the consumer*/
+} ring_t;
+
+/*arguments and result of one thread*/
+typedef struct {
+	const struct mm_ops *mm;
+	long ops;
+	unsigned long long seed;
+	ring_t *ring;       /*-x only, shared with the other thread of the pair*/
+	int failed;
+} thread_arg;
+
+static unsigned long long rnd(unsigned long long *state){
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/*
+ * worker - Random mallocs and frees on a private table of slots
+ */
+static void *worker(void *vargp){
+	thread_arg *arg = (thread_arg *) vargp;
+	unsigned char *slot[SLOTS];
+	size_t size[SLOTS];
+	unsigned char tag;
+	long i;
+	int s;
+
+	memset(slot, 0, sizeof(slot));
+	for (i = 0; i < arg->ops; i++){
+		unsigned long long r = rnd(&arg->seed);
+
+		s = r % SLOTS;
+		tag = (unsigned char) s;
+		if (slot[s] == NULL){
+			size[s] = ((r >> 32) % 100 < 95) ? 8 + (r >> 40) % 248 : 1024 + (r >> 40) % 8192;
+			if ((slot[s] = arg->mm->malloc(size[s])) == NULL){
+				arg->failed = 1;
+				break;
+			}
+			slot[s][0] = slot[s][size[s] - 1] = tag;
+		}
+		else{
+			if (slot[s][0] != tag || slot[s][size[s] - 1] != tag){
+				arg->failed = 1;
+			}
+			arg->mm->free(slot[s]);
+			slot[s] = NULL;
+		}
+	}
+	for (s = 0; s < SLOTS; s++){
+		arg->mm->free(slot[s]);
+	}
+	return NULL;
+}
+
+/*
+ * producer - Allocate blocks and hand them to the consumer of the ring
+ */
+static void *producer(void *vargp){
+	thread_arg *arg = (thread_arg *) vargp;
+	ring_t *ring = arg->ring;
+	unsigned char *p;
+	size_t size;
+	unsigned long i;
+
+	for (i = 0; i < (unsigned long) arg->ops; i++){
+		unsigned long long r = rnd(&arg->seed);
+
+		size = ((r >> 32) % 100 < 95) ? 8 + (r >> 40) % 248 : 1024 + (r >> 40) % 8192;
+		if ((p = arg->mm->malloc(size)) == NULL){
+			arg->failed = 1;
+			size = 0; /*the consumer skips it*/
+		}
+		else{
+			p[0] = p[size - 1] = (unsigned char) i;
+		}
+		while (i - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= RING){
+			sched_yield();
+		}
+		ring->block[i % RING] = p;
+		ring->size[i % RING] = size;
+		__atomic_store_n(&ring->head, i + 1, __ATOMIC_RELEASE);
+	}
+	return NULL;
+}
+
+/*
+ * consumer - Check and free the blocks the producer of the ring hands on
+ */
+static void *consumer(void *vargp){
+	thread_arg *arg = (thread_arg *) vargp;
+	ring_t *ring = arg->ring;
+	unsigned char *p;
+	size_t size;
+	unsigned long i;
+
+	for (i = 0; i < (unsigned long) arg->ops; i++){
+		while (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == i){
+			sched_yield();
+		}
+		p = ring->block[i % RING];
+		size = ring->size[i % RING];
+		if (size > 0 && (p[0] != (unsigned char) i || p[size - 1] != (unsigned char) i)){
+			arg->failed = 1;
+		}
+		arg->mm->free(p);
+		__atomic_store_n(&ring->tail, i + 1, __ATOMIC_RELEASE);
+	}
+	return NULL;
+}
+
+static double now(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * run - Run nthreads workers on one allocator, or nthreads / 2 producer
+ * and consumer pairs if pairs is set, return seconds or -1
+ */
+static double run(const struct mm_ops *mm, int nthreads, long ops, int pairs){
+	pthread_t tid[nthreads];
+	thread_arg arg[nthreads];
+	ring_t *rings = NULL;
+	double start;
+	int i, failed = 0;
+
+	mem_reset_brk();
+	if (mm->init() < 0)
+		return -1;
+	if (pairs && (rings = aligned_alloc(64, nthreads / 2 * sizeof(ring_t))) == NULL)
+		return -1;
+	if (pairs)
+		memset(rings, 0, nthreads / 2 * sizeof(ring_t));
+	start = now();
+	for (i = 0; i < nthreads; i++){
+		arg[i].mm = mm;
+		arg[i].ops = ops;
+		arg[i].seed = 0x9E3779B97F4A7C15ULL * (i + 1);
+		arg[i].ring = pairs ? &rings[i / 2] : NULL;
+		arg[i].failed = 0;
+		pthread_create(&tid[i], NULL, !pairs ? worker : i % 2 == 0 ? producer : consumer, &arg[i]);
+	}
+	for (i = 0; i < nthreads; i++){
+		pthread_join(tid[i], NULL);
+		failed |= arg[i].failed;
+	}
+	free(rings);
+	if (failed || mm->checkheap(0))
+		return -1;
+	return now() - start;
+}
+
+int main(int argc, char **argv){
+	int max_threads = 8, nthreads, pairs = 0, c;
+	long ops = 1000000;
+	size_t j;
+
+	while ((c = getopt(argc, argv, "xt:n:h")) != -1){
+		switch (c){
+		case 'x':
+			pairs = 1;
+			break;
+		case 't':
+			max_threads = atoi(optarg);
+			break;
+		case 'n':
+			ops = atol(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: mtbench [-x] [-t max threads] [-n ops per thread]\n");
+			return 1;
+		}
+	}
+
+	mem_init();
+	printf("%-12s %7s %9s %10s\n", "allocator", "threads", "secs", "Kops/s");
+	for (j = 0; j < NUM_ALLOCATORS; j++){
+		for (nthreads = pairs ? 2 : 1; nthreads <= max_threads; nthreads *= 2){
+			double secs = run(allocators[j], nthreads, ops, pairs);
+
+			if (secs < 0){
+				printf("%-12s %7d %9s\n", allocators[j]->name, nthreads, "FAILED");
+				return 1;
+			}
+			printf("%-12s %7d %9.4f %10.1f\n", allocators[j]->name, nthreads, secs,
+				nthreads * ops / secs / 1e3);
+		}
+	}
+	mem_deinit();
+	return 0;
+}
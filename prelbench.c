@@ -0,0 +1,140 @@
+/*
+ * prelbench.c - Runs a real program on the C library allocator and on
+ * the lab allocator (libmm.so, see mm_preload.c) and compares the two
+ *
+ * The command is run reps times as is and reps times with LD_PRELOAD
+ * set to the library, with its standard output thrown away. For each
+ * allocator we report the best wall clock time and the largest
+ * resident set size of the command and everything it waited for.
+ *
+ * usage: prelbench [-n reps] [-l library] command [args...]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+/*what one run of the command took*/
+typedef struct {
+	double secs;     /*wall clock seconds*/
+	long maxrss_kb;  /*largest resident set, in KB*/
+} run_result;
+
+static double now(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * run - Run argv once, with LD_PRELOAD=preload unless preload is NULL.
+ * Returns 0 on success and -1 if the command could not run or failed.
+ */
+static int run(char **argv, const char *preload, run_result *res){
+	struct rusage ru;
+	double start = now();
+	pid_t pid;
+	int status, fd;
+
+	fflush(stdout); /*or the child flushes our buffer too*/
+	if ((pid = fork()) < 0){
+		perror("prelbench: fork");
+		return -1;
+	}
+	if (pid == 0){
+		if ((fd = open("/dev/null", O_WRONLY)) >= 0){
+			dup2(fd, STDOUT_FILENO);
+			close(fd);
+		}
+		if (preload != NULL)
+			setenv("LD_PRELOAD", preload, 1);
+		else
+			unsetenv("LD_PRELOAD");
+		execvp(argv[0], argv);
+		perror("prelbench: exec");
+		_exit(127);
+	}
+	if (wait4(pid, &status, 0, &ru) < 0){
+		perror("prelbench: wait4");
+		return -1;
+	}
+	res->secs = now() - start;
+	res->maxrss_kb = ru.ru_maxrss;
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0){
+		fprintf(stderr, "prelbench: %s %s\n", argv[0],
+			WIFSIGNALED(status) ? strsignal(WTERMSIG(status)) : "exited with an error");
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * bench - Run argv reps times and print the best time and largest RSS
+ */
+static int bench(const char *name, char **argv, const char *preload, int reps){
+	run_result res, best = {0, 0};
+	int r;
+
+	for (r = 0; r < reps; r++){
+		if (run(argv, preload, &res) < 0){
+			printf("%-10s %9s\n", name, "FAILED");
+			return -1;
+		}
+		if (r == 0 || res.secs < best.secs)
+			best.secs = res.secs;
+		if (res.maxrss_kb > best.maxrss_kb)
+			best.maxrss_kb = res.maxrss_kb;
+	}
+	printf("%-10s %9.3f %12ld\n", name, best.secs, best.maxrss_kb);
+	return 0;
+}
+
+static void usage(void){
+	fprintf(stderr, "usage: prelbench [-n reps] [-l library] command [args...]\n");
+}
+
+int main(int argc, char **argv){
+	char library[PATH_MAX];
+	const char *lib = "./libmm.so";
+	int reps = 3, c, i, failed = 0;
+
+	while ((c = getopt(argc, argv, "+n:l:h")) != -1){
+		switch (c){
+		case 'n':
+			reps = atoi(optarg);
+			if (reps < 1)
+				reps = 1;
+			break;
+		case 'l':
+			lib = optarg;
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+	if (optind == argc){
+		usage();
+		return 1;
+	}
+	if (realpath(lib, library) == NULL){ /*the command may change directory*/
+		perror(lib);
+		return 1;
+	}
+
+	printf("command:");
+	for (i = optind; i < argc; i++)
+		printf(" %s", argv[i]);
+	printf("\n%-10s %9s %12s\n", "allocator", "secs", "max RSS KB");
+	fflush(stdout);
+	failed |= bench("libc", argv + optind, NULL, reps) < 0;
+	failed |= bench("libmm", argv + optind, library, reps) < 0;
+	return failed;
+}
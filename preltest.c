@@ -0,0 +1,68 @@
+/*
+ * preltest.c - Checks the preloaded allocator (libmm.so) on blocks of
+ * some GB
+ *
+ * Grows a block by realloc from 64 bytes to 3 GB, past what an int
+ * counts, checking at every step that the contents moved with it and
+ * touching its last byte, and asks realloc for SIZE_MAX bytes, which
+ * must fail and leave the block as it was. Then it fills more than 2 GB
+ * of heap with blocks just under the mapping threshold, so the heap
+ * itself grows past what an int increment of the break reaches.
+ *
+ * usage: LD_PRELOAD=./libmm.so ./preltest
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define BIG       (3UL << 30) /*final size of the realloc'd block*/
+#define HEAP_BLK  (120 * 1024) /*under the mapping threshold, from the heap*/
+#define HEAP_BLKS 20000        /*about 2.3 GB of them*/
+
+static int fail(const char *what){
+	fprintf(stderr, "preltest: %s\n", what);
+	return 1;
+}
+
+int main(void){
+	static char *blk[HEAP_BLKS];
+	volatile size_t huge = SIZE_MAX; /*not folded, so gcc does not warn*/
+	size_t size, i;
+	char *p, *q;
+
+	if ((p = malloc(64)) == NULL)
+		return fail("malloc of 64 bytes failed");
+	memset(p, 0x5a, 64);
+	for (size = 64; size < BIG; ){
+		size = size * 16 > BIG ? BIG : size * 16;
+		if ((q = realloc(p, size)) == NULL)
+			return fail("realloc to a larger block failed");
+		p = q;
+		for (i = 0; i < 64; i++){
+			if (p[i] != 0x5a)
+				return fail("realloc lost the contents");
+		}
+		p[size - 1] = 1;
+	}
+	if (realloc(p, huge) != NULL)
+		return fail("realloc to SIZE_MAX did not fail");
+	if (p[0] != 0x5a || p[BIG - 1] != 1)
+		return fail("failed realloc changed the block");
+	if ((p = realloc(p, 64)) == NULL || p[63] != 0x5a)
+		return fail("realloc back to 64 bytes failed");
+	free(p);
+
+	for (i = 0; i < HEAP_BLKS; i++){
+		if ((blk[i] = malloc(HEAP_BLK)) == NULL)
+			return fail("heap past 2 GB: malloc failed");
+		blk[i][0] = blk[i][HEAP_BLK - 1] = (char) i;
+	}
+	for (i = 0; i < HEAP_BLKS; i++){
+		if (blk[i][0] != (char) i || blk[i][HEAP_BLK - 1] != (char) i)
+			return fail("heap past 2 GB: blocks overlap");
+		free(blk[i]);
+	}
+	printf("preltest: ok\n");
+	return 0;
+}
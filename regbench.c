@@ -0,0 +1,196 @@
+/*
+ * regbench.c - Benchmark for objects that live as long as a request
+ *
+ * Serves a stream of requests, each allocating 20 to 400 objects (mostly
+ * 16 to 512 bytes, a few of some KB) that all die when it ends, while a
+ * table of long lived blocks is replaced a few at a time between requests
+ * so the heap does not stay tidy. The objects of a request are allocated
+ * and released in three ways: a malloc and a free per object, a malloc
+ * per object and one free_many, and a region (mm_region_create, a bump
+ * of mm_region_alloc per object, one mm_region_destroy).
+ *
+ * For each it prints the time per object, allocation and release
+ * together, the peak heap and the free blocks left once the last
+ * request has ended.
+ *
+ * usage: regbench [-n requests] [-r repeats]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "mm.h"
+#include "memlib.h"
+
+extern const struct mm_ops seg_mm_ops, tlsf_mm_ops, quick_mm_ops;
+extern struct mm_region *seg_mm_region_create(size_t size);
+extern void *seg_mm_region_alloc(struct mm_region *r, size_t size);
+extern void seg_mm_region_destroy(struct mm_region *r);
+extern struct mm_region *tlsf_mm_region_create(size_t size);
+extern void *tlsf_mm_region_alloc(struct mm_region *r, size_t size);
+extern void tlsf_mm_region_destroy(struct mm_region *r);
+extern struct mm_region *quick_mm_region_create(size_t size);
+extern void *quick_mm_region_alloc(struct mm_region *r, size_t size);
+extern void quick_mm_region_destroy(struct mm_region *r);
+
+/*an allocator and its regions*/
+typedef struct {
+	const struct mm_ops *mm;
+	struct mm_region *(*create)(size_t size);
+	void *(*alloc)(struct mm_region *r, size_t size);
+	void (*destroy)(struct mm_region *r);
+} region_ops;
+
+static const region_ops allocators[] = {
+	{ &seg_mm_ops, seg_mm_region_create, seg_mm_region_alloc, seg_mm_region_destroy },
+	{ &tlsf_mm_ops, tlsf_mm_region_create, tlsf_mm_region_alloc, tlsf_mm_region_destroy },
+	{ &quick_mm_ops, quick_mm_region_create, quick_mm_region_alloc, quick_mm_region_destroy },
+};
+
+#define NUM_ALLOCATORS (sizeof(allocators) / sizeof(allocators[0]))
+
+#define LONG_LIVED  2048 /*blocks that outlive the requests*/
+#define REPLACED    4    /*long lived blocks replaced after each request*/
+#define MAX_OBJECTS 400  /*most objects of a request*/
+
+/*ways of releasing the objects of a request*/
+enum { BY_FREE, BY_FREE_MANY, BY_REGION, NUM_WAYS };
+
+static unsigned long long rnd(unsigned long long *state){
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static double now(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * object_size - Size of the next object of a request
+ */
+static size_t object_size(unsigned long long *seed){
+	unsigned long long r = rnd(seed);
+
+	return r % 100 < 98 ? 16 + (r >> 8) % 497 : 2048 + (r >> 8) % 6145;
+}
+
+/*
+ * run - Serve n requests, their objects released one way. Returns the
+ * seconds spent on the objects of the requests, or -1, and the peak heap
+ * and the free blocks left at the end in st.
+ */
+static double run(const region_ops *ops, int way, long n, long *objects,
+		struct mm_heap_stats *st){
+	const struct mm_ops *mm = ops->mm;
+	unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+	static void *live[LONG_LIVED];
+	void *obj[MAX_OBJECTS];
+	struct mm_region *region = NULL;
+	double start, secs = 0;
+	size_t size;
+	long i;
+	int k, count, j;
+
+	mem_reset_brk();
+	if (mm->init() < 0)
+		return -1;
+	for (j = 0; j < LONG_LIVED; j++){
+		if ((live[j] = mm->malloc(16 + rnd(&seed) % 1009)) == NULL)
+			return -1;
+	}
+	*objects = 0;
+	for (i = 0; i < n; i++){
+		count = 20 + rnd(&seed) % (MAX_OBJECTS - 19);
+		start = now();
+		if (way == BY_REGION && (region = ops->create(0)) == NULL)
+			return -1;
+		for (k = 0; k < count; k++){
+			size = object_size(&seed);
+			obj[k] = way == BY_REGION ? ops->alloc(region, size) : mm->malloc(size);
+			if (obj[k] == NULL)
+				return -1;
+			*(char *) obj[k] = 1;
+		}
+		switch (way){
+		case BY_FREE:
+			for (k = 0; k < count; k++)
+				mm->free(obj[k]);
+			break;
+		case BY_FREE_MANY:
+			mm->free_many(obj, count);
+			break;
+		case BY_REGION:
+			ops->destroy(region);
+			break;
+		}
+		secs += now() - start;
+		*objects += count;
+		for (k = 0; k < REPLACED; k++){ /*not timed*/
+			j = rnd(&seed) % LONG_LIVED;
+			mm->free(live[j]);
+			if ((live[j] = mm->malloc(16 + rnd(&seed) % 1009)) == NULL)
+				return -1;
+		}
+	}
+	if (mm->checkheap(0))
+		return -1;
+	mm->stats(st);
+	for (j = 0; j < LONG_LIVED; j++)
+		mm->free(live[j]);
+	return secs;
+}
+
+int main(int argc, char **argv){
+	static const char *ways[] = { "free", "free_many", "region" };
+	struct mm_heap_stats st, best_st = { 0 };
+	long n = 20000, objects = 0;
+	int repeats = 3, way, r, c;
+	size_t j;
+
+	while ((c = getopt(argc, argv, "n:r:h")) != -1){
+		switch (c){
+		case 'n':
+			n = atol(optarg);
+			break;
+		case 'r':
+			repeats = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: regbench [-n requests] [-r repeats]\n");
+			return 1;
+		}
+	}
+
+	mem_init();
+	printf("%-16s %-10s %12s %12s %12s\n", "allocator", "release",
+		"ns/object", "peak KB", "free blocks");
+	for (j = 0; j < NUM_ALLOCATORS; j++){
+		const struct mm_ops *mm = allocators[j].mm;
+
+		for (way = 0; way < NUM_WAYS; way++){
+			double best = -1, secs;
+
+			for (r = 0; r < repeats; r++){ /*the best of the repeats*/
+				if ((secs = run(&allocators[j], way, n, &objects, &st)) < 0){
+					printf("%-16s %-10s %12s\n", mm->name, ways[way], "FAILED");
+					return 1;
+				}
+				if (best < 0 || secs < best){
+					best = secs;
+					best_st = st;
+				}
+			}
+			printf("%-16s %-10s %12.1f %12lu %12lu\n", mm->name, ways[way],
+				best * 1e9 / objects, (unsigned long) (best_st.peak_heap / 1024),
+				(unsigned long) best_st.free_blocks);
+		}
+	}
+	mem_deinit();
+	return 0;
+}
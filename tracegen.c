@@ -0,0 +1,535 @@
+/*
+ * tracegen.c - Generates allocation traces for the benchmark driver
+ *
+ * A trace is a text file in the usual malloc lab format:
+ *
+ *   <suggested heap size>
+ *   <number of ids>
+ *   <number of ops>
+ *   <weight>
+ *   a <id> <bytes>      allocate <bytes> and call the block <id>
+ *   c <id> <bytes>      allocate <bytes> zeroed (calloc) and call the block <id>
+ *   m <id> <align> <bytes>  allocate <bytes> aligned to <align> (memalign)
+ *   r <id> <bytes>      realloc block <id> to <bytes>
+ *   f <id>              free block <id>
+ *
+ * Every workload is a small function that calls the emit helpers below,
+ * and every trace frees all of its blocks at the end. The generator is
+ * deterministic for a given seed, so traces can be regenerated at will.
+ *
+ * usage: tracegen [-s seed] [-n scale] <workload>
+ *        tracegen -l
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*one operation of the trace*/
+typedef struct {
+	char type;   /*'a', 'c', 'm', 'r' or 'f'*/
+	int id;      /*block id*/
+	size_t size; /*bytes requested, unused for 'f'*/
+	size_t align; /*alignment of 'm'*/
+} trace_op;
+
+static trace_op *ops;       /*all generated operations*/
+static int num_ops;         /*number of operations so far*/
+static int max_ops;         /*capacity of ops*/
+static int num_ids;         /*ids handed out so far*/
+static size_t *id_size;     /*current size of each id, 0 if not live*/
+static int max_ids;         /*capacity of id_size*/
+static size_t live_bytes;   /*sum of sizes of live blocks*/
+static size_t peak_bytes;   /*maximum of live_bytes*/
+
+static int *live;           /*ids of live blocks, in no particular order*/
+static int *live_pos;       /*position of each id in live, -1 if not live*/
+static int num_live;        /*number of live blocks*/
+
+static unsigned long long rng_state = 0x2545F4914F6CDD1DULL;
+static int scale = 1;       /*multiplies the size of every workload*/
+
+/*
+ * rnd - xorshift64* generator, good enough to shuffle traces
+ */
+static unsigned long long rnd(void){
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+/*
+ * rnd_range - Uniform random number in [lo, hi]
+ */
+static size_t rnd_range(size_t lo, size_t hi){
+	return lo + (size_t) (rnd() % (hi - lo + 1));
+}
+
+/*
+ * rnd_size - Random request size skewed towards small blocks,
+ * the way most real programs allocate
+ */
+static size_t rnd_size(void){
+	unsigned pick = rnd() % 100;
+
+	if (pick < 70)
+		return rnd_range(1, 128);
+	else if (pick < 95)
+		return rnd_range(129, 2048);
+	return rnd_range(2049, 32768);
+}
+
+static void *xrealloc(void *p, size_t bytes){
+	if ((p = realloc(p, bytes)) == NULL){
+		fprintf(stderr, "tracegen: out of memory\n");
+		exit(1);
+	}
+	return p;
+}
+
+/*
+ * push_op - Append one operation to the trace
+ */
+static void push_op(char type, int id, size_t size){
+	if (num_ops == max_ops){
+		max_ops = max_ops ? 2 * max_ops : 4096;
+		ops = xrealloc(ops, max_ops * sizeof(trace_op));
+	}
+	ops[num_ops].type = type;
+	ops[num_ops].id = id;
+	ops[num_ops].size = size;
+	ops[num_ops].align = 0;
+	num_ops++;
+}
+
+/*
+ * emit_op - Allocate size bytes under a new id with type 'a', 'c' or 'm'
+ */
+static int emit_op(char type, size_t size){
+	int id = num_ids++;
+
+	if (id == max_ids){
+		max_ids = max_ids ? 2 * max_ids : 4096;
+		id_size = xrealloc(id_size, max_ids * sizeof(size_t));
+		live = xrealloc(live, max_ids * sizeof(int));
+		live_pos = xrealloc(live_pos, max_ids * sizeof(int));
+	}
+	push_op(type, id, size);
+	id_size[id] = size;
+	live_pos[id] = num_live;
+	live[num_live++] = id;
+	live_bytes += size;
+	peak_bytes = live_bytes > peak_bytes ? live_bytes : peak_bytes;
+	return id;
+}
+
+/*
+ * emit_alloc - Allocate size bytes under a new id and return the id
+ */
+static int emit_alloc(size_t size){
+	return emit_op('a', size);
+}
+
+/*
+ * emit_calloc - Allocate size zeroed bytes under a new id and return the id
+ */
+static int emit_calloc(size_t size){
+	return emit_op('c', size);
+}
+
+/*
+ * emit_memalign - Allocate size bytes aligned to align under a new id and return the id
+ */
+static int emit_memalign(size_t align, size_t size){
+	int id = emit_op('m', size);
+
+	ops[num_ops - 1].align = align;
+	return id;
+}
+
+/*
+ * emit_realloc - Resize a live id to size bytes
+ */
+static void emit_realloc(int id, size_t size){
+	push_op('r', id, size);
+	live_bytes = live_bytes - id_size[id] + size;
+	id_size[id] = size;
+	peak_bytes = live_bytes > peak_bytes ? live_bytes : peak_bytes;
+}
+
+/*
+ * emit_free - Free a live id
+ */
+static void emit_free(int id){
+	int last = live[--num_live];
+
+	push_op('f', id, 0);
+	live_bytes -= id_size[id];
+	id_size[id] = 0;
+	live[live_pos[id]] = last; /*swap the last live id into the hole*/
+	live_pos[last] = live_pos[id];
+	live_pos[id] = -1;
+}
+
+/*
+ * random_live - Pick one of the live ids at random
+ */
+static int random_live(void){
+	return live[rnd() % num_live];
+}
+
+/*
+ * free_all - Free every live block in random order
+ */
+static void free_all(void){
+	while (num_live > 0){
+		emit_free(random_live());
+	}
+}
+
+/*
+ * Workloads
+ * ---------
+ */
+
+/*
+ * random - Mix of mallocs, frees and reallocs of random sizes
+ */
+static void gen_random(void){
+	int i, n = 8000 * scale;
+
+	for (i = 0; i < n; i++){
+		unsigned pick = rnd() % 100;
+
+		if (num_live == 0 || pick < 50)
+			emit_alloc(rnd_size());
+		else if (pick < 85)
+			emit_free(random_live());
+		else
+			emit_realloc(random_live(), rnd_size());
+	}
+	free_all();
+}
+
+/*
+ * small - Node heavy data structure, lots of 8 to 64 byte objects
+ * with half of them dying early
+ */
+static void gen_small(void){
+	int i, n = 20000 * scale;
+
+	for (i = 0; i < n; i++)
+		emit_alloc(8 * rnd_range(1, 8));
+	for (i = 0; i < n / 2; i++)
+		emit_free(random_live());
+	for (i = 0; i < n / 2; i++)
+		emit_alloc(8 * rnd_range(1, 8));
+	free_all();
+}
+
+/*
+ * binary - Alternating small and large blocks, then all the large
+ * ones are freed and a slightly larger size is requested, which
+ * cannot reuse the holes
+ */
+static void gen_binary(void){
+	int i, n = 2000 * scale;
+	int *big = xrealloc(NULL, n * sizeof(int));
+
+	for (i = 0; i < n; i++){
+		emit_alloc(64);
+		big[i] = emit_alloc(448);
+	}
+	for (i = 0; i < n; i++)
+		emit_free(big[i]);
+	for (i = 0; i < n; i++)
+		emit_alloc(512);
+	free_all();
+	free(big);
+}
+
+/*
+ * realloc - A few buffers that keep growing through realloc,
+ * interleaved with short lived small allocations
+ */
+static void gen_realloc(void){
+	int bufs[4];
+	size_t size[4];
+	int i, j, n = 1200 * scale;
+
+	for (j = 0; j < 4; j++){
+		size[j] = 64;
+		bufs[j] = emit_alloc(size[j]);
+	}
+	for (i = 0; i < n; i++){
+		int tmp = emit_alloc(rnd_range(16, 96));
+
+		j = rnd() % 4;
+		size[j] += rnd_range(16, 512);
+		emit_realloc(bufs[j], size[j]);
+		emit_free(tmp);
+	}
+	free_all();
+}
+
+/*
+ * append - One buffer that grows by a few bytes at a time, the way
+ * a string builder or a vector being appended to does
+ */
+static void gen_append(void){
+	int i, buf, n = 8000 * scale;
+	size_t size = 16;
+
+	for (i = 0; i < 64; i++)
+		emit_alloc(rnd_range(16, 256)); /*some long lived blocks first*/
+	buf = emit_alloc(size);
+	for (i = 0; i < n; i++){
+		size += rnd_range(8, 120);
+		emit_realloc(buf, size);
+	}
+	free_all();
+}
+
+/*
+ * coalesce - Many equal blocks freed together and reused as
+ * blocks of twice the size, which only works if neighbours merge
+ */
+static void gen_coalesce(void){
+	int i, n = 2000 * scale;
+
+	for (i = 0; i < n; i++)
+		emit_alloc(4088);
+	free_all();
+	for (i = 0; i < n / 2; i++)
+		emit_alloc(8184);
+	free_all();
+}
+
+/*
+ * large - Big buffers of 128 KB to 1 MB, most of them grown or
+ * shrunk through realloc, next to a few small blocks
+ */
+static void gen_large(void){
+	int i, n = 400 * scale;
+
+	for (i = 0; i < n; i++){
+		unsigned pick = rnd() % 100;
+
+		if (num_live < 16 || pick < 40){
+			emit_alloc(rnd_range(128 * 1024, 1024 * 1024));
+			emit_alloc(rnd_range(16, 256));
+		}
+		else if (pick < 70)
+			emit_free(random_live());
+		else
+			emit_realloc(random_live(), rnd_range(64 * 1024, 2048 * 1024));
+	}
+	free_all();
+}
+
+/*
+ * peak - A burst of small and medium blocks that is all freed again,
+ * after which the program runs on a small working set; the heap
+ * should shrink back after the burst
+ */
+static void gen_peak(void){
+	int i, n = 20000 * scale;
+	int *burst = xrealloc(NULL, n * sizeof(int));
+
+	for (i = 0; i < 32; i++)
+		emit_alloc(rnd_range(16, 256));
+	for (i = 0; i < n; i++)
+		burst[i] = emit_alloc(rnd_range(16, 1024));
+	for (i = n - 1; i >= 0; i--)
+		emit_free(burst[i]);
+	for (i = 0; i < n; i++){
+		int id = emit_alloc(rnd_range(16, 256));
+
+		emit_free(id);
+	}
+	free(burst);
+	free_all();
+}
+
+/*
+ * calloc - Zeroed arrays of all sizes, some of them new memory and
+ * some reusing freed blocks, with a few large enough to be mapped
+ */
+static void gen_calloc(void){
+	int i, n = 10000 * scale;
+
+	for (i = 0; i < n; i++){
+		unsigned pick = rnd() % 100;
+
+		if (num_live == 0 || pick < 55){
+			if (pick < 2)
+				emit_calloc(rnd_range(64 * 1024, 512 * 1024));
+			else
+				emit_calloc(8 * rnd_range(1, 256));
+		}
+		else if (pick < 90)
+			emit_free(random_live());
+		else
+			emit_alloc(rnd_size()); /*dirty blocks for later callocs*/
+	}
+	free_all();
+}
+
+/*
+ * aligned - Cache line and page aligned blocks mixed with ordinary
+ * ones, the way per thread counters and buffers are allocated
+ */
+static void gen_aligned(void){
+	static const size_t aligns[] = {16, 32, 64, 64, 64, 128, 4096, 8192};
+	int i, n = 8000 * scale;
+
+	for (i = 0; i < n; i++){
+		unsigned pick = rnd() % 100;
+
+		if (num_live == 0 || pick < 25)
+			emit_memalign(aligns[rnd() % 8], pick < 1 ? rnd_range(128 * 1024, 512 * 1024)
+				: rnd_range(8, 512));
+		else if (pick < 50)
+			emit_alloc(rnd_size());
+		else
+			emit_free(random_live());
+	}
+	free_all();
+}
+
+/*
+ * pingpong - Temporaries of a few sizes allocated and freed right away,
+ * over and over, among a working set of blocks that changes slowly
+ */
+static void gen_pingpong(void){
+	static const size_t sizes[] = {24, 40, 96, 200};
+	int i, n = 30000 * scale;
+
+	for (i = 0; i < 256; i++)
+		emit_alloc(rnd_range(16, 512));
+	for (i = 0; i < n; i++){
+		int id = emit_alloc(sizes[i % 4]);
+
+		emit_free(id);
+		if (i % 16 == 0){
+			emit_free(random_live());
+			emit_alloc(rnd_range(16, 512));
+		}
+	}
+	free_all();
+}
+
+/*
+ * prodcons - A producer allocates batches of messages and a consumer
+ * frees them in the order they were made, the way a queue between
+ * two stages of a pipeline does, with now and then a large buffer
+ */
+static void gen_prodcons(void){
+	int i, j, head = 0, tail = 0, n = 4000 * scale;
+	int *queue = xrealloc(NULL, 16 * n * sizeof(int));
+
+	for (i = 0; i < n; i++){
+		int made = rnd_range(1, 16), eaten = rnd_range(1, 16);
+
+		for (j = 0; j < made; j++)
+			queue[tail++] = emit_alloc(rnd_range(32, 320));
+		for (j = 0; j < eaten && head < tail; j++)
+			emit_free(queue[head++]);
+		if (i % 64 == 0){
+			int id = emit_alloc(rnd_range(4096, 16384));
+
+			emit_free(id);
+		}
+	}
+	free(queue);
+	free_all();
+}
+
+typedef struct {
+	const char *name;
+	void (*gen)(void);
+	const char *desc;
+} workload;
+
+static const workload workloads[] = {
+	{"random",   gen_random,   "mix of malloc/free/realloc of random sizes"},
+	{"small",    gen_small,    "8-64 byte nodes, half freed early"},
+	{"binary",   gen_binary,   "alternating 64/448 byte blocks, then 512 byte requests"},
+	{"realloc",  gen_realloc,  "growing buffers with short lived small blocks"},
+	{"append",   gen_append,   "one buffer grown by realloc a few bytes at a time"},
+	{"coalesce", gen_coalesce, "equal blocks freed together and reused at twice the size"},
+	{"large",    gen_large,    "128 KB to 1 MB buffers grown and shrunk by realloc"},
+	{"peak",     gen_peak,     "burst of blocks all freed again, then a small working set"},
+	{"calloc",   gen_calloc,   "zeroed arrays of all sizes, new and reused memory"},
+	{"aligned",  gen_aligned,  "cache line and page aligned blocks among ordinary ones"},
+	{"pingpong", gen_pingpong, "temporaries of four sizes allocated and freed right away"},
+	{"prodcons", gen_prodcons, "message batches freed in the order they were made"},
+};
+
+#define NUM_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+static void usage(void){
+	size_t i;
+
+	fprintf(stderr, "usage: tracegen [-s seed] [-n scale] <workload>\n");
+	fprintf(stderr, "       tracegen -l\n");
+	fprintf(stderr, "workloads:\n");
+	for (i = 0; i < NUM_WORKLOADS; i++)
+		fprintf(stderr, "  %-10s %s\n", workloads[i].name, workloads[i].desc);
+}
+
+int main(int argc, char **argv){
+	const workload *w = NULL;
+	size_t i;
+	int c;
+
+	while ((c = getopt(argc, argv, "s:n:lh")) != -1){
+		switch (c){
+		case 's':
+			rng_state ^= strtoull(optarg, NULL, 0) * 0x9E3779B97F4A7C15ULL;
+			if (rng_state == 0)
+				rng_state = 1;
+			break;
+		case 'n':
+			scale = atoi(optarg);
+			if (scale < 1)
+				scale = 1;
+			break;
+		case 'l':
+			for (i = 0; i < NUM_WORKLOADS; i++)
+				printf("%s\n", workloads[i].name);
+			return 0;
+		default:
+			usage();
+			return 1;
+		}
+	}
+	if (optind != argc - 1){
+		usage();
+		return 1;
+	}
+	for (i = 0; i < NUM_WORKLOADS; i++){
+		if (strcmp(argv[optind], workloads[i].name) == 0)
+			w = &workloads[i];
+	}
+	if (w == NULL){
+		fprintf(stderr, "tracegen: unknown workload %s\n", argv[optind]);
+		usage();
+		return 1;
+	}
+
+	w->gen();
+
+	printf("%lu\n%d\n%d\n%d\n", (unsigned long) peak_bytes, num_ids, num_ops, 1);
+	for (i = 0; i < (size_t) num_ops; i++){
+		if (ops[i].type == 'f')
+			printf("f %d\n", ops[i].id);
+		else if (ops[i].type == 'm')
+			printf("m %d %lu %lu\n", ops[i].id, (unsigned long) ops[i].align,
+				(unsigned long) ops[i].size);
+		else
+			printf("%c %d %lu\n", ops[i].type, ops[i].id, (unsigned long) ops[i].size);
+	}
+	return 0;
+}